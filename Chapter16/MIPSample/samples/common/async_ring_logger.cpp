@@ -0,0 +1,266 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "async_ring_logger.h"
+
+#include <ctime>
+#include <sstream>
+#include <stdexcept>
+
+#include "string_utils.h"
+
+using mip::LogLevel;
+using std::chrono::system_clock;
+using std::lock_guard;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::mutex;
+using std::runtime_error;
+using std::string;
+using std::unique_lock;
+
+namespace {
+
+// How often the writer thread looks for new records when it is idle. Producers never signal the writer, so this
+// bounds how long a record can sit in the ring before it is written.
+static const std::chrono::milliseconds kWriterPollInterval(20);
+// Records formatted before the buffer is handed to the file in one write
+static const size_t kWriteBatchSize = 1024;
+
+const char* GetLogLevelString(LogLevel level) {
+  switch (level) {
+    case LogLevel::Trace: return "Trace";
+    case LogLevel::Info: return "Info";
+    case LogLevel::Warning: return "Warning";
+    case LogLevel::Error: return "Error";
+    default: return "Unknown";
+  }
+}
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 2;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+
+FILE* OpenLogFile(const string& logFilePath) {
+#ifdef _WIN32
+  FILE* file = _wfopen(ConvertStringToWString(logFilePath).c_str(), L"ab");
+#else
+  FILE* file = fopen(logFilePath.c_str(), "ab");
+#endif
+  if (file == nullptr)
+    throw runtime_error("Failed to open log file: " + logFilePath);
+  return file;
+}
+
+void FormatTime(system_clock::time_point time, std::ostringstream& out) {
+  const std::time_t seconds = system_clock::to_time_t(time);
+  const auto milliseconds =
+      std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count() % 1000;
+  std::tm utc;
+#ifdef _WIN32
+  gmtime_s(&utc, &seconds);
+#else
+  gmtime_r(&seconds, &utc);
+#endif
+  char buffer[32];
+  strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+  char fraction[8];
+  snprintf(fraction, sizeof(fraction), ".%03dZ", static_cast<int>(milliseconds));
+  out << buffer << fraction;
+}
+
+} // namespace
+
+namespace sample {
+namespace logging {
+
+AsyncRingLogger::AsyncRingLogger(const string& logFilePath, LogLevel logLevel, size_t capacity)
+    : mLogLevel(logLevel),
+      mMask(RoundUpToPowerOfTwo(capacity) - 1),
+      mEnqueuePosition(0),
+      mDequeuePosition(0),
+      mDroppedCount(0),
+      mWrittenCount(0),
+      mFile(OpenLogFile(logFilePath)),
+      mStopping(false),
+      mFlushTarget(0),
+      mFlushedPosition(0) {
+  mSlots.reset(new Slot[mMask + 1]);
+  for (size_t i = 0; i <= mMask; i++)
+    mSlots[i].sequence.store(i, memory_order_relaxed);
+
+  mWriterThread = std::thread(&AsyncRingLogger::WriterLoop, this);
+}
+
+AsyncRingLogger::~AsyncRingLogger() {
+  Flush();
+  {
+    lock_guard<mutex> lock(mFlushMutex);
+    mStopping = true;
+  }
+  mFlushRequested.notify_all();
+  mWriterThread.join();
+  fclose(mFile);
+}
+
+void AsyncRingLogger::Init(const string& /*storagePath*/, LogLevel logLevel) {
+  // The log file is chosen by the application, only the level comes from the SDK
+  mLogLevel = logLevel;
+}
+
+void AsyncRingLogger::WriteToLog(
+    const LogLevel level,
+    const string& message,
+    const string& function,
+    const string& file,
+    const int32_t line) {
+  if (level < mLogLevel.load(memory_order_relaxed))
+    return;
+
+  // Bounded multi-producer queue: claim a position, then publish the slot by bumping its sequence
+  size_t position = mEnqueuePosition.load(memory_order_relaxed);
+  Slot* slot;
+  for (;;) {
+    slot = &mSlots[position & mMask];
+    const size_t sequence = slot->sequence.load(memory_order_acquire);
+    const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (difference == 0) {
+      if (mEnqueuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+        break;
+    } else if (difference < 0) {
+      // Ring is full: the writer has not caught up, drop rather than block the SDK thread
+      mDroppedCount++;
+      return;
+    } else {
+      position = mEnqueuePosition.load(memory_order_relaxed);
+    }
+  }
+
+  Record& record = slot->record;
+  record.level = level;
+  record.time = system_clock::now();
+  record.threadId = std::this_thread::get_id();
+  record.message = message;
+  record.function = function;
+  record.file = file;
+  record.line = line;
+  slot->sequence.store(position + 1, memory_order_release);
+}
+
+bool AsyncRingLogger::TryDequeue(Record& record) {
+  Slot& slot = mSlots[mDequeuePosition & mMask];
+  if (slot.sequence.load(memory_order_acquire) != mDequeuePosition + 1)
+    return false; // Empty, or the producer that claimed this slot has not published it yet
+
+  std::swap(record, slot.record);
+  slot.sequence.store(mDequeuePosition + mMask + 1, memory_order_release);
+  mDequeuePosition++;
+  return true;
+}
+
+void AsyncRingLogger::Flush() {
+  // Everything claimed so far must be written; slots claimed but not yet published are waited for by the writer
+  const size_t target = mEnqueuePosition.load(memory_order_acquire);
+  unique_lock<mutex> lock(mFlushMutex);
+  if (target > mFlushTarget)
+    mFlushTarget = target;
+  mFlushRequested.notify_one();
+  mFlushCompleted.wait(lock, [&] { return mFlushedPosition >= target || mStopping; });
+}
+
+void AsyncRingLogger::WriterLoop() {
+  Record record;
+  std::ostringstream batch;
+  size_t flushedTarget = 0; // Last flush target the file was fflush'ed for
+
+  for (;;) {
+    size_t flushTarget;
+    bool stopping;
+    {
+      unique_lock<mutex> lock(mFlushMutex);
+      mFlushRequested.wait_for(lock, kWriterPollInterval, [&] { return mFlushTarget > mFlushedPosition || mStopping; });
+      flushTarget = mFlushTarget;
+      stopping = mStopping;
+    }
+
+    size_t batchCount = 0;
+    for (;;) {
+      if (!TryDequeue(record)) {
+        // A flush must not return while a record it covers is still being published
+        if (mDequeuePosition < flushTarget) {
+          std::this_thread::yield();
+          continue;
+        }
+        break;
+      }
+
+      FormatTime(record.time, batch);
+      batch << " [" << GetLogLevelString(record.level) << "] [" << record.threadId << "] " << record.message
+          << " (" << record.function << " " << record.file << ":" << record.line << ")\n";
+      batchCount++;
+
+      if (batchCount == kWriteBatchSize) {
+        const string text = batch.str();
+        fwrite(text.data(), 1, text.size(), mFile);
+        batch.str(string());
+        mWrittenCount += batchCount;
+        batchCount = 0;
+      }
+    }
+
+    if (batchCount > 0) {
+      const string text = batch.str();
+      fwrite(text.data(), 1, text.size(), mFile);
+      batch.str(string());
+      mWrittenCount += batchCount;
+    }
+
+    // Only fflush for a new Flush() call; regular batches are left to stdio buffering
+    if (flushTarget > flushedTarget || stopping) {
+      fflush(mFile);
+      flushedTarget = flushTarget;
+
+      // Flush() calls made while this batch was written are only released once the next iteration fflushes for them
+      {
+        lock_guard<mutex> lock(mFlushMutex);
+        if (flushTarget > mFlushedPosition)
+          mFlushedPosition = flushTarget;
+      }
+      mFlushCompleted.notify_all();
+    }
+
+    if (stopping)
+      return;
+  }
+}
+
+} // namespace logging
+} // namespace sample
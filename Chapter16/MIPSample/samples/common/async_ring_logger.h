@@ -0,0 +1,115 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_ASYNC_RING_LOGGER_H_
+#define SAMPLES_COMMON_ASYNC_RING_LOGGER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "mip/logger_delegate.h"
+
+namespace sample {
+namespace logging {
+
+// mip::LoggerDelegate that never blocks the SDK thread calling WriteToLog.
+//
+// Records go into a fixed-size lock-free ring buffer that any number of threads can write to. A dedicated thread
+// takes them out in batches, formats them and appends them to the log file. When the ring is full the record is
+// dropped and counted instead of waiting for the writer. Flush() returns once every record written before the call
+// is on disk.
+class AsyncRingLogger final : public mip::LoggerDelegate {
+public:
+  // capacity is rounded up to a power of two
+  AsyncRingLogger(const std::string& logFilePath, mip::LogLevel logLevel, size_t capacity = 64 * 1024);
+  ~AsyncRingLogger();
+
+  AsyncRingLogger(const AsyncRingLogger&) = delete;
+  AsyncRingLogger& operator=(const AsyncRingLogger&) = delete;
+
+  void Init(const std::string& storagePath, mip::LogLevel logLevel) override;
+  mip::LogLevel GetLogLevel() const override { return mLogLevel; }
+  void Flush() override;
+  void WriteToLog(
+      const mip::LogLevel level,
+      const std::string& message,
+      const std::string& function,
+      const std::string& file,
+      const int32_t line) override;
+
+  uint64_t GetDroppedCount() const { return mDroppedCount; }
+  uint64_t GetWrittenCount() const { return mWrittenCount; }
+
+private:
+  struct Record {
+    mip::LogLevel level;
+    std::chrono::system_clock::time_point time;
+    std::thread::id threadId;
+    std::string message;
+    std::string function;
+    std::string file;
+    int32_t line;
+  };
+
+  struct Slot {
+    // Sequence number telling producers and the consumer whose turn the slot is
+    std::atomic<size_t> sequence;
+    Record record;
+  };
+
+  bool TryDequeue(Record& record);
+  void WriterLoop();
+
+  std::atomic<mip::LogLevel> mLogLevel;
+  std::unique_ptr<Slot[]> mSlots;
+  size_t mMask;
+  std::atomic<size_t> mEnqueuePosition;
+  size_t mDequeuePosition; // Only touched by the writer thread
+  std::atomic<uint64_t> mDroppedCount;
+  std::atomic<uint64_t> mWrittenCount;
+
+  FILE* mFile;
+  std::atomic<bool> mStopping;
+  std::mutex mFlushMutex;
+  std::condition_variable mFlushRequested;
+  std::condition_variable mFlushCompleted;
+  size_t mFlushTarget;
+  size_t mFlushedPosition;
+  std::thread mWriterThread;
+};
+
+} // namespace logging
+} // namespace sample
+
+#endif // SAMPLES_COMMON_ASYNC_RING_LOGGER_H_
@@ -54,17 +54,16 @@ using custom_unique_ptr = unique_ptr<T, function<void(T*)>>;
 namespace {
 
 string Execute(const char* cmd) {
-    char buffer[128];
-    string result = "";
+  char buffer[4096];
+  string result = "";
 
   custom_unique_ptr<FILE> pipe(POPEN(cmd, "r"), [](FILE* f) { PCLOSE(f); });
   if (nullptr == pipe.get())
     throw runtime_error("popen() failed");
 
-  while (!feof(pipe.get())) {
-    if (fgets(buffer, 128, pipe.get()) != NULL)
-      result += buffer;
-  }
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), pipe.get())) > 0)
+    result.append(buffer, count);
 
   return result;
 }
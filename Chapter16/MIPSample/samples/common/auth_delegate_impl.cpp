@@ -30,6 +30,9 @@
 #include <stdexcept>
 
 #include "auth.h"
+#ifndef _WIN32
+#include "shared_token_cache.h"
+#endif // _WIN32
 
 using std::runtime_error;
 using std::string;
@@ -42,12 +45,28 @@ AuthDelegateImpl::AuthDelegateImpl(
     const string& clientId,
     const string& sccToken,
     const string& protectionToken,
-    const string& workingDirectory)
+    const string& workingDirectory,
+    const std::shared_ptr<SharedTokenCache>& sharedTokenCache)
     : mPassword(password),
       mClientId(clientId),
       mSccToken(sccToken),
       mProtectionToken(protectionToken),
-      mWorkingDirectory(workingDirectory) {
+      mWorkingDirectory(workingDirectory),
+      mSharedTokenCache(sharedTokenCache) {
+  // Tokens are acquired through an external script, which is far too slow to run for every challenge. The cache
+  // makes concurrent challenges for the same resource share one acquisition and renews tokens before they expire.
+  TokenCache::Fetcher acquire = [this](const string& userName, const string& resource, const string& authority) {
+    return AcquireToken(userName, mPassword, mClientId, resource, authority, mWorkingDirectory);
+  };
+#ifndef _WIN32
+  // Other processes on the machine may already hold the token
+  if (mSharedTokenCache) {
+    acquire = [this, acquire](const string& userName, const string& resource, const string& authority) {
+      return mSharedTokenCache->GetToken(userName, resource, authority, acquire);
+    };
+  }
+#endif // _WIN32
+  mTokenCache.reset(new TokenCache(acquire));
 }
 
 bool AuthDelegateImpl::AcquireOAuth2Token(
@@ -69,7 +88,7 @@ bool AuthDelegateImpl::AcquireOAuth2Token(
   if (mPassword.empty())
     throw runtime_error("Empty password");
 
-  const string& tokenStr = AcquireToken(identity.GetEmail(), mPassword, mClientId, challenge.GetResource(), challenge.GetAuthority(), mWorkingDirectory);
+  const string& tokenStr = mTokenCache->GetToken(identity.GetEmail(), challenge.GetResource(), challenge.GetAuthority());
   token.SetAccessToken(tokenStr);
   return true;
 }
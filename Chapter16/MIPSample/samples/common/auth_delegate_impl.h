@@ -28,13 +28,17 @@
 #ifndef SAMPLES_COMMON_AUTH_DELEGATE_IMPL_H_
 #define SAMPLES_COMMON_AUTH_DELEGATE_IMPL_H_
 
+#include <memory>
 #include <string>
 
 #include "mip/common_types.h"
+#include "token_cache.h"
 
 namespace sample {
 namespace auth {
 
+class SharedTokenCache;
+
 class AuthDelegateImpl final : public mip::AuthDelegate {
 public:
   AuthDelegateImpl() = delete;
@@ -44,7 +48,8 @@ public:
       const std::string& clientId,
       const std::string& sccToken,
       const std::string& protectionToken,
-      const std::string& workingDirectory = "");
+      const std::string& workingDirectory = "",
+      const std::shared_ptr<SharedTokenCache>& sharedTokenCache = nullptr); // Not available on Windows
 
   bool AcquireOAuth2Token(const mip::Identity& identity, const OAuth2Challenge& challenge, OAuth2Token& token) override;
 
@@ -54,6 +59,9 @@ private:
   std::string mSccToken;
   std::string mProtectionToken;
   std::string mWorkingDirectory;
+  std::shared_ptr<SharedTokenCache> mSharedTokenCache;
+  // Declared last: its fetcher reads the members above
+  std::unique_ptr<TokenCache> mTokenCache;
 };
 
 } // namespace sample
@@ -0,0 +1,210 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include "batch_policy_evaluator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+#include "mip/upe/content_label.h"
+#include "mip/upe/label.h"
+#include "mip/upe/policy_handler.h"
+#include "pooled_execution_state.h"
+
+using mip::Action;
+using mip::PolicyEngine;
+using mip::PolicyHandler;
+using std::atomic;
+using std::lock_guard;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+namespace sample {
+namespace upe {
+
+namespace {
+
+// Output of one chunk that has to be merged into the shared columns
+struct ChunkResult {
+  size_t begin = 0;
+  vector<uint32_t> actionCounts;
+  vector<shared_ptr<Action>> actions;
+};
+
+} // namespace
+
+const uint32_t PolicyActionTable::kNoLabel;
+
+BatchPolicyEvaluator::BatchPolicyEvaluator(
+    const shared_ptr<PolicyEngine>& policyEngine,
+    size_t workerCount,
+    bool keepActions,
+    size_t chunkSize)
+  : mPolicyEngine(policyEngine),
+    mWorkerCount(workerCount > 0 ? workerCount : 1),
+    mKeepActions(keepActions),
+    mChunkSize(chunkSize > 0 ? chunkSize : 1) {
+  if (!mPolicyEngine)
+    throw std::invalid_argument("BatchPolicyEvaluator requires a policy engine");
+}
+
+PolicyActionTable BatchPolicyEvaluator::Evaluate(const vector<PolicyRecord>& records) const {
+  PolicyActionTable table;
+  table.labelIndex.assign(records.size(), PolicyActionTable::kNoLabel);
+  table.actionMask.assign(records.size(), 0);
+
+  const size_t chunkCount = (records.size() + mChunkSize - 1) / mChunkSize;
+  vector<ChunkResult> chunkResults(mKeepActions ? chunkCount : 0);
+  atomic<size_t> nextChunk(0);
+  atomic<size_t> readyWorkers(0);
+  mutex sharedMutex; // Guards the label dictionary, the errors and the exceptions below
+  unordered_map<string, uint32_t> labelDictionary;
+  std::exception_ptr handlerError;
+  std::exception_ptr fatalError;
+
+  auto worker = [&]() {
+    // The SDK does not document PolicyHandler as safe for concurrent calls, so each worker has its own
+    shared_ptr<PolicyHandler> policyHandler;
+    try {
+      policyHandler = mPolicyEngine->CreatePolicyHandler(false /*isAuditDiscoveryEnabled*/);
+    } catch (...) {
+      // The other workers take over this worker's share of the chunks
+      lock_guard<mutex> lock(sharedMutex);
+      handlerError = std::current_exception();
+      return;
+    }
+    readyWorkers++;
+
+    try {
+      PooledExecutionState state;
+      // Label IDs already resolved to dictionary indexes by this worker, to take the shared lock only for new ones
+      unordered_map<string, uint32_t> localLabels;
+
+      for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+        const size_t begin = chunk * mChunkSize;
+        const size_t end = begin + mChunkSize < records.size() ? begin + mChunkSize : records.size();
+        ChunkResult* chunkResult = mKeepActions ? &chunkResults[chunk] : nullptr;
+        if (chunkResult) {
+          chunkResult->begin = begin;
+          chunkResult->actionCounts.assign(end - begin, 0);
+        }
+
+        for (size_t i = begin; i < end; i++) {
+          const PolicyRecord& record = records[i];
+          try {
+            state.Reset();
+            state.SetContentIdentifier(record.contentIdentifier);
+            state.SetContentState(record.contentState);
+            state.SetNewLabel(record.newLabelId, record.assignmentMethod, mip::ActionSource::MANUAL);
+            for (const auto& item : record.metadata)
+              state.AddContentMetadata(item.first, item.second);
+
+            const auto contentLabel = policyHandler->GetSensitivityLabel(state);
+            if (contentLabel && contentLabel->GetLabel()) {
+              const string& labelId = contentLabel->GetLabel()->GetId();
+              auto it = localLabels.find(labelId);
+              if (it == localLabels.end()) {
+                lock_guard<mutex> lock(sharedMutex);
+                auto inserted = labelDictionary.emplace(labelId, static_cast<uint32_t>(table.labelIds.size()));
+                if (inserted.second)
+                  table.labelIds.push_back(labelId);
+                it = localLabels.emplace(labelId, inserted.first->second).first;
+              }
+              table.labelIndex[i] = it->second;
+            }
+
+            uint32_t mask = 0;
+            auto actions = policyHandler->ComputeActions(state);
+            for (const auto& action : actions)
+              mask |= static_cast<uint32_t>(action->GetType());
+            table.actionMask[i] = mask;
+            if (chunkResult) {
+              chunkResult->actionCounts[i - begin] = static_cast<uint32_t>(actions.size());
+              chunkResult->actions.insert(chunkResult->actions.end(), actions.begin(), actions.end());
+            }
+          } catch (const std::exception& ex) {
+            lock_guard<mutex> lock(sharedMutex);
+            table.errors.emplace_back(i, ex.what());
+          }
+        }
+      }
+    } catch (...) {
+      // Failures of single records are reported in the table, this is running out of memory and the like
+      lock_guard<mutex> lock(sharedMutex);
+      if (!fatalError)
+        fatalError = std::current_exception();
+      nextChunk = chunkCount; // Stop the other workers too
+    }
+  };
+
+  vector<std::thread> workers;
+  const size_t workerCount = mWorkerCount < chunkCount ? mWorkerCount : chunkCount;
+  workers.reserve(workerCount); // So starting a thread is the only thing below that can throw
+  for (size_t i = 1; i < workerCount; i++) {
+    try {
+      workers.emplace_back(worker);
+    } catch (const std::system_error&) {
+      // Out of threads: the workers that did start, and the calling thread, take all the chunks between them
+      break;
+    }
+  }
+  if (chunkCount > 0)
+    worker(); // The calling thread is one of the workers
+  for (auto& thread : workers)
+    thread.join();
+
+  if (fatalError)
+    std::rethrow_exception(fatalError);
+  // No worker got a handler, so nothing was evaluated
+  if (chunkCount > 0 && readyWorkers == 0)
+    std::rethrow_exception(handlerError);
+
+  std::sort(table.errors.begin(), table.errors.end());
+
+  if (mKeepActions) {
+    table.actionOffsets.reserve(records.size() + 1);
+    table.actionOffsets.push_back(0);
+    for (auto& chunkResult : chunkResults) {
+      for (uint32_t count : chunkResult.actionCounts)
+        table.actionOffsets.push_back(table.actionOffsets.back() + count);
+      table.actions.insert(table.actions.end(), chunkResult.actions.begin(), chunkResult.actions.end());
+      vector<shared_ptr<Action>>().swap(chunkResult.actions);
+    }
+  }
+  return table;
+}
+
+} // namespace upe
+} // namespace sample
@@ -0,0 +1,99 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef SAMPLES_COMMON_BATCH_POLICY_EVALUATOR_H_
+#define SAMPLES_COMMON_BATCH_POLICY_EVALUATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mip/common_types.h"
+#include "mip/upe/action.h"
+#include "mip/upe/policy_engine.h"
+
+namespace sample {
+namespace upe {
+
+// What is known about one item without opening it, typically a row of a content database
+struct PolicyRecord {
+  std::string contentIdentifier;
+  // The item's label metadata as stored with it, e.g. the MSIP_Label_* properties
+  std::vector<std::pair<std::string, std::string>> metadata;
+  // Label to evaluate the change to, empty to evaluate the item as it is
+  std::string newLabelId;
+  mip::AssignmentMethod assignmentMethod = mip::AssignmentMethod::STANDARD;
+  mip::ContentState contentState = mip::ContentState::REST;
+};
+
+// Results of a batch, one column per attribute and one row per record, in record order
+struct PolicyActionTable {
+  static const uint32_t kNoLabel = 0xFFFFFFFF;
+
+  std::vector<std::string> labelIds; // Distinct current label IDs, referenced by labelIndex
+  std::vector<uint32_t> labelIndex; // Current label of each record, or kNoLabel
+  std::vector<uint32_t> actionMask; // mip::ActionType bits of the actions computed for each record
+  // Only filled when the evaluator keeps actions: the actions of record i are
+  // actions[actionOffsets[i]] up to actions[actionOffsets[i + 1]]
+  std::vector<uint32_t> actionOffsets;
+  std::vector<std::shared_ptr<mip::Action>> actions;
+  std::vector<std::pair<size_t, std::string>> errors; // Record index and message of the records that failed
+
+  size_t GetRecordCount() const { return labelIndex.size(); }
+};
+
+// Evaluates label policy for metadata records, without opening any content. Records are split into chunks that a
+// fixed set of worker threads take in turn; each worker evaluates through its own PolicyHandler and a reused
+// PooledExecutionState, and writes straight into its rows of the result columns.
+class BatchPolicyEvaluator final {
+public:
+  // keepActions also returns the mip::Action objects, which are needed to carry out the actions but cost memory
+  // for every record that has any
+  BatchPolicyEvaluator(
+      const std::shared_ptr<mip::PolicyEngine>& policyEngine,
+      size_t workerCount,
+      bool keepActions = false,
+      size_t chunkSize = 1024);
+
+  BatchPolicyEvaluator(const BatchPolicyEvaluator&) = delete;
+  BatchPolicyEvaluator& operator=(const BatchPolicyEvaluator&) = delete;
+
+  PolicyActionTable Evaluate(const std::vector<PolicyRecord>& records) const;
+
+private:
+  std::shared_ptr<mip::PolicyEngine> mPolicyEngine;
+  size_t mWorkerCount;
+  bool mKeepActions;
+  size_t mChunkSize;
+};
+
+} // namespace upe
+} // namespace sample
+
+#endif // SAMPLES_COMMON_BATCH_POLICY_EVALUATOR_H_
@@ -0,0 +1,380 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include "content_classifier.h"
+
+#include <cstring>
+
+#include "mapped_file_stream.h"
+
+using mip::ClassificationResult;
+using sample::utils::MappedFileStream;
+using std::make_shared;
+using std::map;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace sample {
+namespace classification {
+
+namespace {
+
+enum : uint8_t {
+  kDigit = 1,
+  kUpper = 2,
+  kLower = 4,
+  kSeparator = 8, // May sit between the digit groups of a number
+};
+
+// Longer runs of digits and capitals are data (hashes, serials, base64), not the numbers looked for
+const size_t kMaxTokenLength = 64;
+// Shortest value of any type (an SSN), shorter tokens are skipped without looking at them
+const size_t kMinValueLength = 9;
+// Longest value of any type (an IBAN), which bounds how many groups of a token are joined into one candidate
+const size_t kMaxValueLength = 34;
+
+struct CharClasses {
+  uint8_t table[256];
+
+  CharClasses() {
+    memset(table, 0, sizeof(table));
+    for (int c = '0'; c <= '9'; c++)
+      table[c] = kDigit;
+    for (int c = 'A'; c <= 'Z'; c++)
+      table[c] = kUpper;
+    for (int c = 'a'; c <= 'z'; c++)
+      table[c] = kLower;
+    table[static_cast<uint8_t>(' ')] = kSeparator;
+    table[static_cast<uint8_t>('-')] = kSeparator;
+  }
+};
+
+const CharClasses kClasses;
+
+inline bool Is(uint8_t c, uint8_t classes) {
+  return (kClasses.table[c] & classes) != 0;
+}
+
+// True if any of the eight bytes of word is an ASCII digit (0x30-0x39), without looking at the bytes one by one
+inline bool HasDigitByte(uint64_t word) {
+  const uint64_t ones = 0x0101010101010101ULL;
+  const uint64_t highBits = 0x8080808080808080ULL;
+  const uint64_t low = word & (ones * 127);
+  return ((ones * (127 + 0x3A) - low) & ~word & (low + ones * (127 - 0x2F)) & highBits) != 0;
+}
+
+// Every value of every type contains a digit, so only digits can start a candidate
+size_t FindNextDigit(const uint8_t* data, size_t position, size_t size) {
+  for (;;) {
+    while (position + sizeof(uint64_t) <= size) {
+      uint64_t word;
+      memcpy(&word, data + position, sizeof(word));
+      if (HasDigitByte(word))
+        break;
+      position += sizeof(word);
+    }
+    const size_t end = position + sizeof(uint64_t) < size ? position + sizeof(uint64_t) : size;
+    for (; position < end; position++) {
+      if (Is(data[position], kDigit))
+        return position;
+    }
+    if (position >= size)
+      return size;
+  }
+}
+
+bool IsLuhnValid(const char* digits, size_t length) {
+  int sum = 0;
+  bool doubled = false;
+  for (size_t i = length; i-- > 0;) {
+    int digit = digits[i] - '0';
+    if (doubled) {
+      digit *= 2;
+      if (digit > 9)
+        digit -= 9;
+    }
+    sum += digit;
+    doubled = !doubled;
+  }
+  return sum % 10 == 0;
+}
+
+int Prefix(const char* digits, size_t count) {
+  int value = 0;
+  for (size_t i = 0; i < count; i++)
+    value = value * 10 + (digits[i] - '0');
+  return value;
+}
+
+bool IsCardIssuerPrefix(const char* digits, size_t length) {
+  const int two = Prefix(digits, 2);
+  const int three = Prefix(digits, 3);
+  const int four = Prefix(digits, 4);
+  if (digits[0] == '4')
+    return length == 13 || length == 16 || length == 19; // Visa
+  if (two == 34 || two == 37)
+    return length == 15; // American Express
+  if ((two >= 51 && two <= 55) || (four >= 2221 && four <= 2720))
+    return length == 16; // Mastercard
+  if (four == 6011 || two == 65 || (three >= 644 && three <= 649))
+    return length >= 16; // Discover
+  if (four >= 3528 && four <= 3589)
+    return length >= 16; // JCB
+  if (two == 36 || two == 38 || two == 39 || (three >= 300 && three <= 305))
+    return length >= 14; // Diners Club
+  return false;
+}
+
+bool IsCreditCardNumber(const char* value, size_t length) {
+  return length >= 13 && length <= 19 && IsCardIssuerPrefix(value, length) && IsLuhnValid(value, length);
+}
+
+size_t GetIbanLength(const char* countryCode) {
+  static const struct { char code[3]; size_t length; } kLengths[] = {
+    { "AD", 24 }, { "AT", 20 }, { "BE", 16 }, { "CH", 21 }, { "CY", 28 }, { "CZ", 24 }, { "DE", 22 }, { "DK", 18 },
+    { "EE", 20 }, { "ES", 24 }, { "FI", 18 }, { "FR", 27 }, { "GB", 22 }, { "GR", 27 }, { "HR", 21 }, { "HU", 28 },
+    { "IE", 22 }, { "IS", 26 }, { "IT", 27 }, { "LI", 21 }, { "LT", 20 }, { "LU", 20 }, { "LV", 21 }, { "MC", 27 },
+    { "MT", 31 }, { "NL", 18 }, { "NO", 15 }, { "PL", 28 }, { "PT", 25 }, { "RO", 24 }, { "SE", 24 }, { "SI", 19 },
+    { "SK", 24 }, { "SM", 27 },
+  };
+  for (const auto& entry : kLengths) {
+    if (entry.code[0] == countryCode[0] && entry.code[1] == countryCode[1])
+      return entry.length;
+  }
+  return 0;
+}
+
+bool IsIban(const char* value, size_t length) {
+  if (length < 15 || !Is(value[0], kUpper) || !Is(value[1], kUpper) || !Is(value[2], kDigit) ||
+      !Is(value[3], kDigit) || GetIbanLength(value) != length)
+    return false;
+
+  // Checksum over the account number followed by country code and check digits, letters counting as 10 to 35
+  int remainder = 0;
+  for (size_t i = 0; i < length; i++) {
+    const char c = value[(i + 4) % length];
+    if (Is(c, kDigit)) {
+      remainder = (remainder * 10 + (c - '0')) % 97;
+    } else {
+      remainder = (remainder * 100 + (c - 'A' + 10)) % 97;
+    }
+  }
+  return remainder == 1;
+}
+
+bool IsSsnIssuable(const char* digits) {
+  const int area = Prefix(digits, 3);
+  return area != 0 && area != 666 && area < 900 && Prefix(digits + 3, 2) != 0 && Prefix(digits + 5, 4) != 0;
+}
+
+bool IsAllDigits(const char* value, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if (!Is(value[i], kDigit))
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+vector<SensitiveInfoType> GetBuiltInSensitiveInfoTypes() {
+  return {
+    { "50842eb7-edc8-4019-85dd-5a5c1f2bb085", "Credit Card Number", SensitiveInfoKind::CreditCardNumber },
+    { "e7dc4711-11b7-4cb0-b88b-2c394a771f0e", "International Banking Account Number (IBAN)", SensitiveInfoKind::Iban },
+    { "a44669fe-0d48-453d-a9b1-2cc83f2cba77", "U.S. Social Security Number (SSN)", SensitiveInfoKind::UsSocialSecurityNumber },
+  };
+}
+
+map<string, shared_ptr<ClassificationResult>> ContentClassification::GetResults(
+    const vector<string>& classificationIds) const {
+  map<string, shared_ptr<ClassificationResult>> results;
+  for (const auto& id : classificationIds) {
+    auto it = mResults.find(id);
+    if (it != mResults.end())
+      results.insert(*it);
+  }
+  return results;
+}
+
+ContentClassifier::ContentClassifier(const vector<SensitiveInfoType>& types)
+  : mTypes(types),
+    mTypesByKind(static_cast<size_t>(SensitiveInfoKind::UsSocialSecurityNumber) + 1) {
+  for (size_t i = 0; i < mTypes.size(); i++)
+    mTypesByKind[static_cast<size_t>(mTypes[i].kind)].push_back(i);
+}
+
+ContentClassification ContentClassifier::Scan(const uint8_t* data, size_t size) const {
+  vector<int> counts(mTypes.size(), 0);
+  vector<int> confidence(mTypes.size(), 0);
+
+  size_t position = 0;
+  while (!mTypes.empty() && position < size) {
+    position = FindNextDigit(data, position, size);
+    if (position == size)
+      break;
+
+    // A token is a run of digits and capitals, single separators allowed between them. IBANs start with their two
+    // letter country code, so a token may begin two capitals before the digit that was found.
+    size_t start = position;
+    if (start >= 2 && Is(data[start - 1], kUpper) && Is(data[start - 2], kUpper) &&
+        (start == 2 || !Is(data[start - 3], kDigit | kUpper | kLower))) {
+      start -= 2;
+    } else if (start > 0 && Is(data[start - 1], kDigit | kUpper | kLower)) {
+      // The digit is inside a word such as "v2" or "0x1f", none of which can hold a value
+      while (position < size && Is(data[position], kDigit | kUpper | kLower))
+        position++;
+      continue;
+    }
+
+    size_t end = start;
+    while (end < size && end - start <= kMaxTokenLength) {
+      if (Is(data[end], kDigit | kUpper)) {
+        end++;
+      } else if (Is(data[end], kSeparator) && !Is(data[end - 1], kSeparator) && end + 1 < size &&
+          Is(data[end + 1], kDigit | kUpper)) {
+        end++;
+      } else {
+        break;
+      }
+    }
+
+    if (end - start > kMaxTokenLength || (end < size && Is(data[end], kLower))) {
+      // Too long, or runs on into a word: skip all of it rather than rescanning its tail
+      while (end < size && Is(data[end], kDigit | kUpper | kLower | kSeparator))
+        end++;
+      position = end;
+      continue;
+    }
+
+    if (end - start >= kMinValueLength)
+      ScanToken(data + start, end - start, counts, confidence);
+    position = end;
+  }
+
+  ContentClassification classification;
+  for (size_t i = 0; i < mTypes.size(); i++) {
+    if (counts[i] > 0)
+      classification.mResults[mTypes[i].id] = make_shared<SensitiveInfoResult>(mTypes[i].id, counts[i], confidence[i]);
+  }
+  return classification;
+}
+
+ContentClassification ContentClassifier::ScanFile(const string& filePath) const {
+  MappedFileStream stream(filePath);
+  vector<uint8_t> content(static_cast<size_t>(stream.Size()));
+  size_t size = 0;
+  while (size < content.size()) {
+    const int64_t count = stream.Read(content.data() + size, static_cast<int64_t>(content.size() - size));
+    if (count <= 0)
+      break;
+    size += static_cast<size_t>(count);
+  }
+  return Scan(content.data(), size);
+}
+
+// Tries the groups of the token from longest to shortest run, so that "4111 1111 1111 1111" is one card number while
+// "4111111111111111 4012888888881881" is two.
+void ContentClassifier::ScanToken(
+    const uint8_t* token,
+    size_t length,
+    vector<int>& counts,
+    vector<int>& confidence) const {
+  struct Group {
+    size_t begin;
+    size_t end;
+  };
+  Group groups[kMaxTokenLength / 2 + 1];
+  size_t groupCount = 0;
+  for (size_t i = 0; i < length;) {
+    const size_t begin = i;
+    while (i < length && !Is(token[i], kSeparator))
+      i++;
+    groups[groupCount++] = { begin, i };
+    i++; // Separators are single, see Scan
+  }
+
+  const bool wantCards = !mTypesByKind[static_cast<size_t>(SensitiveInfoKind::CreditCardNumber)].empty();
+  const bool wantIbans = !mTypesByKind[static_cast<size_t>(SensitiveInfoKind::Iban)].empty();
+  const bool wantSsns = !mTypesByKind[static_cast<size_t>(SensitiveInfoKind::UsSocialSecurityNumber)].empty();
+
+  char value[kMaxTokenLength];
+  size_t first = 0;
+  while (first < groupCount) {
+    // Furthest group that keeps the joined value short enough to be anything
+    size_t last = first;
+    size_t joinedLength = groups[first].end - groups[first].begin;
+    while (last + 1 < groupCount && joinedLength + groups[last + 1].end - groups[last + 1].begin <= kMaxValueLength) {
+      last++;
+      joinedLength += groups[last].end - groups[last].begin;
+    }
+
+    bool matched = false;
+    for (size_t end = last + 1; end-- > first && !matched;) {
+      size_t valueLength = 0;
+      for (size_t g = first; g <= end; g++) {
+        memcpy(value + valueLength, token + groups[g].begin, groups[g].end - groups[g].begin);
+        valueLength += groups[g].end - groups[g].begin;
+      }
+
+      const size_t groupsJoined = end - first + 1;
+      if (wantIbans && IsIban(value, valueLength)) {
+        Record(Match{ SensitiveInfoKind::Iban, 85 }, counts, confidence);
+        matched = true;
+      } else if (!IsAllDigits(value, valueLength)) {
+        continue;
+      } else if (wantCards && IsCreditCardNumber(value, valueLength)) {
+        Record(Match{ SensitiveInfoKind::CreditCardNumber, 85 }, counts, confidence);
+        matched = true;
+      } else if (wantSsns && valueLength == 9 && IsSsnIssuable(value)) {
+        // Only the usual layouts, and the separators must agree
+        const bool formatted = groupsJoined == 3 &&
+            groups[first].end - groups[first].begin == 3 &&
+            groups[first + 1].end - groups[first + 1].begin == 2 &&
+            token[groups[first].end] == token[groups[first + 1].end];
+        if (groupsJoined == 1 || formatted) {
+          Record(Match{ SensitiveInfoKind::UsSocialSecurityNumber, formatted ? 75 : 65 }, counts, confidence);
+          matched = true;
+        }
+      }
+      if (matched)
+        first = end + 1;
+    }
+    if (!matched)
+      first++;
+  }
+}
+
+void ContentClassifier::Record(const Match& match, vector<int>& counts, vector<int>& confidence) const {
+  for (size_t index : mTypesByKind[static_cast<size_t>(match.kind)]) {
+    counts[index]++;
+    if (match.confidenceLevel > confidence[index])
+      confidence[index] = match.confidenceLevel;
+  }
+}
+
+} // namespace classification
+} // namespace sample
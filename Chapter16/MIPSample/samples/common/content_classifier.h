@@ -0,0 +1,120 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef SAMPLES_COMMON_CONTENT_CLASSIFIER_H_
+#define SAMPLES_COMMON_CONTENT_CLASSIFIER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mip/upe/classification_result.h"
+
+namespace sample {
+namespace classification {
+
+enum class SensitiveInfoKind {
+  CreditCardNumber, // 13 to 19 digits with a known issuer prefix and a valid Luhn check digit
+  Iban, // Country code, check digits and account number of the country's length, valid mod-97 checksum
+  UsSocialSecurityNumber, // ddd-dd-dddd, ddd dd dddd or ddddddddd, excluding never-issued areas, groups and serials
+};
+
+struct SensitiveInfoType {
+  std::string id; // Classification ID the policy refers to
+  std::string name;
+  SensitiveInfoKind kind;
+};
+
+// The built-in types, identified by the IDs of the matching Microsoft 365 sensitive information types
+std::vector<SensitiveInfoType> GetBuiltInSensitiveInfoTypes();
+
+class SensitiveInfoResult final : public mip::ClassificationResult {
+public:
+  SensitiveInfoResult(const std::string& id, int count, int confidenceLevel)
+    : mId(id), mCount(count), mConfidenceLevel(confidenceLevel) {}
+
+  std::string GetId() const override { return mId; }
+  int GetCount() const override { return mCount; }
+  int GetConfidenceLevel() const override { return mConfidenceLevel; }
+
+private:
+  std::string mId;
+  int mCount;
+  int mConfidenceLevel;
+};
+
+// Matches found in one piece of content, by classification ID. Types without a match have no entry.
+class ContentClassification final {
+public:
+  // In the shape ExecutionState::GetClassificationResults returns: only the requested IDs that were found
+  std::map<std::string, std::shared_ptr<mip::ClassificationResult>> GetResults(
+      const std::vector<std::string>& classificationIds) const;
+  const std::map<std::string, std::shared_ptr<mip::ClassificationResult>>& GetAllResults() const { return mResults; }
+
+private:
+  friend class ContentClassifier;
+  std::map<std::string, std::shared_ptr<mip::ClassificationResult>> mResults;
+};
+
+// Finds sensitive information in text content in a single pass. Bytes that cannot start a match are skipped eight at
+// a time; every candidate token is then checked against all configured types at once, so adding types costs
+// validation work only on candidates, not another pass over the content. Immutable after construction and safe to
+// share between threads.
+//
+// Content is scanned as stored: compressed or encrypted files (Office, most PDFs, protected files) need to be
+// decoded by the caller first.
+class ContentClassifier final {
+public:
+  explicit ContentClassifier(const std::vector<SensitiveInfoType>& types = GetBuiltInSensitiveInfoTypes());
+
+  ContentClassification Scan(const uint8_t* data, size_t size) const;
+  // Reads the whole file and scans it. The file is read rather than mapped, so one truncated by another process
+  // while it is scanned cannot take the process down with SIGBUS.
+  ContentClassification ScanFile(const std::string& filePath) const;
+
+  const std::vector<SensitiveInfoType>& GetTypes() const { return mTypes; }
+
+private:
+  struct Match {
+    SensitiveInfoKind kind;
+    int confidenceLevel;
+  };
+
+  void ScanToken(const uint8_t* token, size_t length, std::vector<int>& counts, std::vector<int>& confidence) const;
+  void Record(const Match& match, std::vector<int>& counts, std::vector<int>& confidence) const;
+
+  std::vector<SensitiveInfoType> mTypes;
+  // Indexes into mTypes, by SensitiveInfoKind
+  std::vector<std::vector<size_t>> mTypesByKind;
+};
+
+} // namespace classification
+} // namespace sample
+
+#endif // SAMPLES_COMMON_CONTENT_CLASSIFIER_H_
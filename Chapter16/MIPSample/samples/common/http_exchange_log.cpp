@@ -0,0 +1,158 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "http_exchange_log.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+using mip::HttpRequestType;
+using std::istream;
+using std::ostream;
+using std::runtime_error;
+using std::string;
+
+namespace {
+
+static const char kRedacted[] = "<redacted>";
+// Larger than any request or response the SDK exchanges, so a longer field means the log is corrupt
+static const size_t kMaxFieldLength = 256 * 1024 * 1024;
+
+bool IsAuthorizationHeader(const string& name) {
+  static const string kAuthorization = "authorization";
+  if (name.size() != kAuthorization.size())
+    return false;
+  for (size_t i = 0; i < name.size(); i++) {
+    if (tolower(static_cast<unsigned char>(name[i])) != kAuthorization[i])
+      return false;
+  }
+  return true;
+}
+
+void WriteField(ostream& out, const string& value) {
+  out << value.size() << ':';
+  out.write(value.data(), value.size());
+}
+
+void WriteHeaders(ostream& out, const sample::http::HttpHeaders& headers, bool redactAuthorization) {
+  WriteField(out, std::to_string(headers.size()));
+  for (const auto& header : headers) {
+    WriteField(out, header.first);
+    const bool redact = redactAuthorization && IsAuthorizationHeader(header.first);
+    WriteField(out, redact ? kRedacted : header.second);
+  }
+}
+
+string ReadField(istream& in) {
+  size_t length = 0;
+  char c;
+  bool hasDigits = false;
+  while (in.get(c) && c >= '0' && c <= '9') {
+    length = length * 10 + (c - '0');
+    hasDigits = true;
+    // Checked per digit, so a long run of digits cannot overflow length either
+    if (length > kMaxFieldLength)
+      throw runtime_error("Malformed HTTP exchange log");
+  }
+  if (!in || c != ':' || !hasDigits)
+    throw runtime_error("Malformed HTTP exchange log");
+
+  string value(length, '\0');
+  if (length > 0 && !in.read(&value[0], length))
+    throw runtime_error("Truncated HTTP exchange log");
+  return value;
+}
+
+size_t ReadCount(istream& in) {
+  const string count = ReadField(in);
+  char* end = nullptr;
+  const unsigned long value = strtoul(count.c_str(), &end, 10);
+  if (count.empty() || *end != '\0')
+    throw runtime_error("Malformed HTTP exchange log");
+  return static_cast<size_t>(value);
+}
+
+void ReadHeaders(istream& in, sample::http::HttpHeaders& headers) {
+  headers.clear();
+  const size_t count = ReadCount(in);
+  for (size_t i = 0; i < count; i++) {
+    string name = ReadField(in);
+    headers[name] = ReadField(in);
+  }
+}
+
+} // namespace
+
+namespace sample {
+namespace http {
+
+void WriteHttpExchange(ostream& out, const HttpExchange& exchange) {
+  WriteField(out, exchange.type == HttpRequestType::Post ? "POST" : "GET");
+  WriteField(out, exchange.url);
+  WriteHeaders(out, exchange.requestHeaders, true /*redactAuthorization*/);
+  WriteField(out, exchange.requestBody);
+  WriteField(out, std::to_string(exchange.statusCode));
+  WriteHeaders(out, exchange.responseHeaders, false /*redactAuthorization*/);
+  WriteField(out, exchange.responseBody);
+  out << '\n';
+}
+
+bool ReadHttpExchange(istream& in, HttpExchange& exchange) {
+  if (in.peek() == istream::traits_type::eof())
+    return false;
+
+  const string type = ReadField(in);
+  if (type == "POST")
+    exchange.type = HttpRequestType::Post;
+  else if (type == "GET")
+    exchange.type = HttpRequestType::Get;
+  else
+    throw runtime_error("Unknown request type in HTTP exchange log: " + type);
+
+  exchange.url = ReadField(in);
+  ReadHeaders(in, exchange.requestHeaders);
+  exchange.requestBody = ReadField(in);
+  exchange.statusCode = static_cast<int32_t>(ReadCount(in));
+  ReadHeaders(in, exchange.responseHeaders);
+  exchange.responseBody = ReadField(in);
+
+  if (in.get() != '\n')
+    throw runtime_error("Malformed HTTP exchange log");
+  return true;
+}
+
+string GetHttpExchangeKey(HttpRequestType type, const string& url, const string& body) {
+  string key(type == HttpRequestType::Post ? "POST " : "GET ");
+  key += url;
+  key += '\n';
+  key += body;
+  return key;
+}
+
+} // namespace http
+} // namespace sample
@@ -0,0 +1,66 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_HTTP_EXCHANGE_LOG_H_
+#define SAMPLES_COMMON_HTTP_EXCHANGE_LOG_H_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "http_message_impl.h"
+#include "mip/http_request.h"
+
+namespace sample {
+namespace http {
+
+// One request and the response it got, as stored by RecordingHttpDelegate and served by ReplayHttpDelegate
+struct HttpExchange {
+  mip::HttpRequestType type = mip::HttpRequestType::Get;
+  std::string url;
+  HttpHeaders requestHeaders;
+  std::string requestBody;
+  int32_t statusCode = 0;
+  HttpHeaders responseHeaders;
+  std::string responseBody;
+};
+
+// The log is a sequence of exchanges, one per line. Every field is written as "<length>:<bytes>", so bodies may hold
+// any bytes, including newlines, without escaping. The value of an Authorization request header is never written.
+void WriteHttpExchange(std::ostream& out, const HttpExchange& exchange);
+
+// Returns false at the end of the log. Throws std::runtime_error if the log is malformed.
+bool ReadHttpExchange(std::istream& in, HttpExchange& exchange);
+
+// Replay lookup key. Headers are left out on purpose: they carry tokens and correlation IDs that differ between runs.
+std::string GetHttpExchangeKey(mip::HttpRequestType type, const std::string& url, const std::string& body);
+
+} // namespace http
+} // namespace sample
+
+#endif // SAMPLES_COMMON_HTTP_EXCHANGE_LOG_H_
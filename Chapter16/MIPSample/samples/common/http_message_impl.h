@@ -0,0 +1,90 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_HTTP_MESSAGE_IMPL_H_
+#define SAMPLES_COMMON_HTTP_MESSAGE_IMPL_H_
+
+#include <map>
+#include <string>
+
+#include "mip/common_types.h"
+#include "mip/http_request.h"
+#include "mip/http_response.h"
+
+namespace sample {
+namespace http {
+
+typedef std::map<std::string, std::string, mip::CaseInsensitiveComparator> HttpHeaders;
+
+// Plain value implementations of the SDK's HTTP interfaces, used by the sample HttpDelegates
+class HttpRequestImpl final : public mip::HttpRequest {
+public:
+  HttpRequestImpl(
+      mip::HttpRequestType type,
+      const std::string& url,
+      const std::string& body = std::string(),
+      const HttpHeaders& headers = HttpHeaders())
+      : mType(type),
+        mUrl(url),
+        mBody(body),
+        mHeaders(headers) {
+  }
+
+  mip::HttpRequestType GetRequestType() const override { return mType; }
+  const std::string& GetUrl() const override { return mUrl; }
+  const std::string& GetBody() const override { return mBody; }
+  const HttpHeaders& GetHeaders() const override { return mHeaders; }
+
+private:
+  mip::HttpRequestType mType;
+  std::string mUrl;
+  std::string mBody;
+  HttpHeaders mHeaders;
+};
+
+class HttpResponseImpl final : public mip::HttpResponse {
+public:
+  HttpResponseImpl(int32_t statusCode, const std::string& body, const HttpHeaders& headers)
+      : mStatusCode(statusCode),
+        mBody(body),
+        mHeaders(headers) {
+  }
+
+  int32_t GetStatusCode() const override { return mStatusCode; }
+  const std::string& GetBody() const override { return mBody; }
+  const HttpHeaders& GetHeaders() const override { return mHeaders; }
+
+private:
+  int32_t mStatusCode;
+  std::string mBody;
+  HttpHeaders mHeaders;
+};
+
+} // namespace http
+} // namespace sample
+
+#endif // SAMPLES_COMMON_HTTP_MESSAGE_IMPL_H_
@@ -0,0 +1,115 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "latency_recorder.h"
+
+#include <algorithm>
+#include <cmath>
+
+using std::lock_guard;
+using std::mutex;
+using std::ostream;
+using std::vector;
+
+namespace {
+
+// Nearest-rank percentile of an already sorted, non-empty sample set: the smallest sample that at least percentile
+// percent of the samples are less than or equal to
+double Percentile(const vector<double>& sorted, double percentile) {
+  size_t rank = static_cast<size_t>(std::ceil(percentile * sorted.size() / 100.0));
+  if (rank == 0)
+    rank = 1;
+  if (rank > sorted.size())
+    rank = sorted.size();
+  return sorted[rank - 1];
+}
+
+} // namespace
+
+namespace sample {
+namespace utils {
+
+ostream& operator<<(ostream& out, const LatencySummary& summary) {
+  return out << "count=" << summary.count << " mean=" << summary.meanMs << "ms p50=" << summary.p50Ms
+      << "ms p95=" << summary.p95Ms << "ms p99=" << summary.p99Ms << "ms max=" << summary.maxMs << "ms";
+}
+
+LatencyRecorder::LatencyRecorder(size_t maxSamples)
+  : mMaxSamples(maxSamples > 0 ? maxSamples : 1),
+    mCount(0),
+    mTotal(0),
+    mMax(0) {
+}
+
+void LatencyRecorder::Record(double milliseconds) {
+  lock_guard<mutex> lock(mMutex);
+  mCount++;
+  mTotal += milliseconds;
+  if (mCount == 1 || milliseconds > mMax)
+    mMax = milliseconds;
+
+  // Reservoir sampling: once full, the n-th latency replaces a random sample with probability maxSamples / n
+  if (mSamples.size() < mMaxSamples) {
+    mSamples.push_back(milliseconds);
+  } else {
+    const uint64_t slot = std::uniform_int_distribution<uint64_t>(0, mCount - 1)(mRandom);
+    if (slot < mMaxSamples)
+      mSamples[static_cast<size_t>(slot)] = milliseconds;
+  }
+}
+
+LatencySummary LatencyRecorder::GetSummary() const {
+  vector<double> samples;
+  LatencySummary summary;
+  {
+    lock_guard<mutex> lock(mMutex);
+    samples = mSamples;
+    summary.count = static_cast<size_t>(mCount);
+    summary.meanMs = mCount > 0 ? mTotal / mCount : 0;
+    summary.maxMs = mMax;
+  }
+
+  if (samples.empty())
+    return summary;
+
+  std::sort(samples.begin(), samples.end());
+  summary.p50Ms = Percentile(samples, 50);
+  summary.p95Ms = Percentile(samples, 95);
+  summary.p99Ms = Percentile(samples, 99);
+  return summary;
+}
+
+void LatencyRecorder::Clear() {
+  lock_guard<mutex> lock(mMutex);
+  mSamples.clear();
+  mCount = 0;
+  mTotal = 0;
+  mMax = 0;
+}
+
+} // namespace utils
+} // namespace sample
@@ -0,0 +1,77 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_LATENCY_RECORDER_H_
+#define SAMPLES_COMMON_LATENCY_RECORDER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <vector>
+
+namespace sample {
+namespace utils {
+
+struct LatencySummary {
+  size_t count = 0;
+  double meanMs = 0;
+  double p50Ms = 0;
+  double p95Ms = 0;
+  double p99Ms = 0;
+  double maxMs = 0;
+};
+
+std::ostream& operator<<(std::ostream& out, const LatencySummary& summary);
+
+// Thread-safe collection of latency samples (in milliseconds) with percentile reporting.
+//
+// Memory stays bounded however long the run: count, mean and max are exact, while percentiles come from a uniform
+// random sample of at most maxSamples latencies, which is every latency until that many have been recorded.
+class LatencyRecorder final {
+public:
+  explicit LatencyRecorder(size_t maxSamples = 8192);
+
+  void Record(double milliseconds);
+  LatencySummary GetSummary() const;
+  void Clear();
+
+private:
+  const size_t mMaxSamples;
+  mutable std::mutex mMutex;
+  std::vector<double> mSamples; // Reservoir of the recorded latencies
+  uint64_t mCount;
+  double mTotal;
+  double mMax;
+  std::mt19937_64 mRandom;
+};
+
+} // namespace utils
+} // namespace sample
+
+#endif // SAMPLES_COMMON_LATENCY_RECORDER_H_
@@ -0,0 +1,181 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "mapped_file_stream.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "string_utils.h"
+
+using std::runtime_error;
+using std::string;
+
+namespace sample {
+namespace utils {
+
+#ifdef _WIN32
+MappedFileStream::MappedFileStream(const string& filePath)
+    : mData(nullptr),
+      mSize(0),
+      mPosition(0),
+      mFile(INVALID_HANDLE_VALUE),
+      mMapping(nullptr) {
+  mFile = CreateFileW(ConvertStringToWString(filePath).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (mFile == INVALID_HANDLE_VALUE)
+    throw runtime_error("Failed to open file: " + filePath);
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(mFile, &size)) {
+    CloseHandle(mFile);
+    throw runtime_error("Failed to get size of file: " + filePath);
+  }
+  mSize = size.QuadPart;
+
+  // Zero-length files cannot be mapped; they simply read as empty
+  if (mSize > 0) {
+    mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mMapping != nullptr)
+      mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    if (mData == nullptr) {
+      if (mMapping != nullptr)
+        CloseHandle(mMapping);
+      CloseHandle(mFile);
+      throw runtime_error("Failed to map file: " + filePath);
+    }
+  }
+}
+
+MappedFileStream::~MappedFileStream() {
+  if (mData != nullptr)
+    UnmapViewOfFile(mData);
+  if (mMapping != nullptr)
+    CloseHandle(mMapping);
+  CloseHandle(mFile);
+}
+
+const uint8_t* MappedFileStream::Data() {
+  return mData;
+}
+
+int64_t MappedFileStream::Read(uint8_t* buffer, int64_t bufferLength) {
+  if (bufferLength <= 0 || mPosition >= mSize)
+    return 0;
+
+  int64_t count = mSize - mPosition < bufferLength ? mSize - mPosition : bufferLength;
+  memcpy(buffer, mData + mPosition, static_cast<size_t>(count));
+  mPosition += count;
+  return count;
+}
+#else
+MappedFileStream::MappedFileStream(const string& filePath)
+    : mData(nullptr),
+      mSize(0),
+      mPosition(0),
+      mFd(-1),
+      mFilePath(filePath) {
+  mFd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (mFd < 0)
+    throw runtime_error("Failed to open file: " + filePath);
+
+  struct stat info;
+  if (fstat(mFd, &info) != 0) {
+    close(mFd);
+    throw runtime_error("Failed to get size of file: " + filePath);
+  }
+  mSize = static_cast<int64_t>(info.st_size);
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(mFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+MappedFileStream::~MappedFileStream() {
+  if (mData != nullptr)
+    munmap(const_cast<uint8_t*>(mData), static_cast<size_t>(mSize));
+  close(mFd);
+}
+
+const uint8_t* MappedFileStream::Data() {
+  // Zero-length files cannot be mapped; they simply read as empty
+  if (mData == nullptr && mSize > 0) {
+    void* data = mmap(nullptr, static_cast<size_t>(mSize), PROT_READ, MAP_PRIVATE, mFd, 0);
+    if (data == MAP_FAILED)
+      throw runtime_error("Failed to map file: " + mFilePath);
+    madvise(data, static_cast<size_t>(mSize), MADV_SEQUENTIAL);
+    mData = static_cast<const uint8_t*>(data);
+  }
+  return mData;
+}
+
+int64_t MappedFileStream::Read(uint8_t* buffer, int64_t bufferLength) {
+  if (bufferLength <= 0 || mPosition >= mSize)
+    return 0;
+
+  int64_t count = mSize - mPosition < bufferLength ? mSize - mPosition : bufferLength;
+  ssize_t result;
+  do {
+    result = pread(mFd, buffer, static_cast<size_t>(count), static_cast<off_t>(mPosition));
+  } while (result < 0 && errno == EINTR);
+  if (result < 0)
+    throw runtime_error("Failed to read file: " + mFilePath);
+  // A file truncated since it was opened reads short, which the SDK sees as the end of the stream
+  mPosition += result;
+  return result;
+}
+#endif // _WIN32
+
+int64_t MappedFileStream::Write(const uint8_t* /*buffer*/, int64_t /*bufferLength*/) {
+  throw runtime_error("MappedFileStream is read-only");
+}
+
+bool MappedFileStream::Flush() {
+  return true;
+}
+
+void MappedFileStream::Seek(int64_t position) {
+  if (position < 0)
+    throw runtime_error("Invalid stream position");
+  mPosition = position;
+}
+
+void MappedFileStream::Size(int64_t /*value*/) {
+  throw runtime_error("MappedFileStream is read-only");
+}
+
+} // namespace utils
+} // namespace sample
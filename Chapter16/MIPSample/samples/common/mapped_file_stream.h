@@ -0,0 +1,85 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_MAPPED_FILE_STREAM_H_
+#define SAMPLES_COMMON_MAPPED_FILE_STREAM_H_
+
+#include <cstdint>
+#include <string>
+
+#include "mip/stream.h"
+
+namespace sample {
+namespace utils {
+
+// Read-only mip::Stream over a file that copies straight from the page cache into the SDK's buffer, avoiding the
+// extra buffering layer of CreateStreamFromStdStream. The file is hinted for sequential access so the kernel reads
+// ahead aggressively.
+//
+// On POSIX, Read uses pread rather than the mapping: touching a mapped page past the end of a file that another
+// process truncated raises SIGBUS and would kill a whole sweep, while pread just comes back short. Windows does not
+// let a mapped file be truncated, so reads there come from the mapping.
+class MappedFileStream final : public mip::Stream {
+public:
+  explicit MappedFileStream(const std::string& filePath);
+  ~MappedFileStream();
+
+  MappedFileStream(const MappedFileStream&) = delete;
+  MappedFileStream& operator=(const MappedFileStream&) = delete;
+
+  int64_t Read(uint8_t* buffer, int64_t bufferLength) override;
+  int64_t Write(const uint8_t* buffer, int64_t bufferLength) override;
+  bool Flush() override;
+  void Seek(int64_t position) override;
+  bool CanRead() const override { return true; }
+  bool CanWrite() const override { return false; }
+  int64_t Position() override { return mPosition; }
+  int64_t Size() override { return mSize; }
+  void Size(int64_t value) override;
+
+  // Direct view of the mapped content, valid for the lifetime of the stream. On POSIX the file is mapped on first
+  // use, and reading the view raises SIGBUS if the file is truncated meanwhile, so only use it for files nothing
+  // else modifies. Returns null for an empty file.
+  const uint8_t* Data();
+
+private:
+  const uint8_t* mData;
+  int64_t mSize;
+  int64_t mPosition;
+#ifdef _WIN32
+  void* mFile;
+  void* mMapping;
+#else
+  int mFd;
+  std::string mFilePath;
+#endif
+};
+
+} // namespace utils
+} // namespace sample
+
+#endif // SAMPLES_COMMON_MAPPED_FILE_STREAM_H_
@@ -0,0 +1,93 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include "memory_stream.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+using std::runtime_error;
+using std::vector;
+
+namespace sample {
+namespace utils {
+
+MemoryStream::MemoryStream(size_t initialCapacity)
+  : mPosition(0) {
+  mBuffer.reserve(initialCapacity);
+}
+
+int64_t MemoryStream::Read(uint8_t* buffer, int64_t bufferLength) {
+  const int64_t size = Size();
+  if (bufferLength <= 0 || mPosition >= size)
+    return 0;
+
+  int64_t count = size - mPosition < bufferLength ? size - mPosition : bufferLength;
+  memcpy(buffer, mBuffer.data() + mPosition, static_cast<size_t>(count));
+  mPosition += count;
+  return count;
+}
+
+int64_t MemoryStream::Write(const uint8_t* buffer, int64_t bufferLength) {
+  if (bufferLength <= 0)
+    return 0;
+
+  const size_t end = static_cast<size_t>(mPosition + bufferLength);
+  if (end > mBuffer.size()) {
+    // Grow geometrically, resize alone would only add what this write needs
+    if (end > mBuffer.capacity())
+      mBuffer.reserve(end > mBuffer.capacity() * 2 ? end : mBuffer.capacity() * 2);
+    mBuffer.resize(end);
+  }
+  memcpy(mBuffer.data() + mPosition, buffer, static_cast<size_t>(bufferLength));
+  mPosition += bufferLength;
+  return bufferLength;
+}
+
+void MemoryStream::Seek(int64_t position) {
+  if (position < 0)
+    throw runtime_error("Invalid stream position");
+  mPosition = position;
+}
+
+void MemoryStream::Size(int64_t value) {
+  if (value < 0)
+    throw runtime_error("Invalid stream size");
+  mBuffer.resize(static_cast<size_t>(value));
+  if (mPosition > value)
+    mPosition = value;
+}
+
+vector<uint8_t> MemoryStream::TakeBuffer() {
+  vector<uint8_t> buffer;
+  buffer.swap(mBuffer);
+  mPosition = 0;
+  return buffer;
+}
+
+} // namespace utils
+} // namespace sample
@@ -0,0 +1,70 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef SAMPLES_COMMON_MEMORY_STREAM_H_
+#define SAMPLES_COMMON_MEMORY_STREAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mip/stream.h"
+
+namespace sample {
+namespace utils {
+
+// Growable read/write mip::Stream kept entirely in memory, for committing a FileHandler without an output file.
+// Once the SDK is done with it, TakeBuffer() hands the content over without copying it.
+class MemoryStream final : public mip::Stream {
+public:
+  // initialCapacity avoids regrowing the buffer when the output size is roughly known, e.g. the input size
+  explicit MemoryStream(size_t initialCapacity = 0);
+
+  MemoryStream(const MemoryStream&) = delete;
+  MemoryStream& operator=(const MemoryStream&) = delete;
+
+  int64_t Read(uint8_t* buffer, int64_t bufferLength) override;
+  int64_t Write(const uint8_t* buffer, int64_t bufferLength) override;
+  bool Flush() override { return true; }
+  void Seek(int64_t position) override;
+  bool CanRead() const override { return true; }
+  bool CanWrite() const override { return true; }
+  int64_t Position() override { return mPosition; }
+  int64_t Size() override { return static_cast<int64_t>(mBuffer.size()); }
+  void Size(int64_t value) override;
+
+  // Moves the content out and leaves the stream empty
+  std::vector<uint8_t> TakeBuffer();
+
+private:
+  std::vector<uint8_t> mBuffer;
+  int64_t mPosition;
+};
+
+} // namespace utils
+} // namespace sample
+
+#endif // SAMPLES_COMMON_MEMORY_STREAM_H_
@@ -0,0 +1,96 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "ndjson_writer.h"
+
+using std::lock_guard;
+using std::mutex;
+using std::string;
+
+namespace sample {
+namespace utils {
+
+void AppendJsonString(string& out, const string& str) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  out += '"';
+  for (char c : str) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out += "\\u00";
+          out += kHexDigits[(c >> 4) & 0xF];
+          out += kHexDigits[c & 0xF];
+        } else {
+          // Bytes of multi-byte UTF-8 sequences pass through unchanged
+          out += c;
+        }
+        break;
+    }
+  }
+  out += '"';
+}
+
+NdjsonWriter::NdjsonWriter(FILE* file, size_t flushThreshold)
+  : mFile(file),
+    mFlushThreshold(flushThreshold) {
+  mBuffer.reserve(flushThreshold + 4096);
+}
+
+NdjsonWriter::~NdjsonWriter() {
+  Flush();
+}
+
+void NdjsonWriter::Write(const string& record) {
+  lock_guard<mutex> lock(mMutex);
+  mBuffer += record;
+  mBuffer += '\n';
+  if (mBuffer.size() >= mFlushThreshold)
+    FlushLocked();
+}
+
+void NdjsonWriter::Flush() {
+  lock_guard<mutex> lock(mMutex);
+  FlushLocked();
+  fflush(mFile);
+}
+
+void NdjsonWriter::FlushLocked() {
+  if (mBuffer.empty())
+    return;
+  fwrite(mBuffer.data(), 1, mBuffer.size(), mFile);
+  mBuffer.clear();
+}
+
+} // namespace utils
+} // namespace sample
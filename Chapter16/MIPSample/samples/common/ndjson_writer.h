@@ -0,0 +1,68 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_NDJSON_WRITER_H_
+#define SAMPLES_COMMON_NDJSON_WRITER_H_
+
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+namespace sample {
+namespace utils {
+
+// Appends str to out as a quoted JSON string, escaping quotes, backslashes and control characters.
+void AppendJsonString(std::string& out, const std::string& str);
+
+// Thread-safe writer of newline-delimited JSON records. Records are collected in memory and written to the FILE with a
+// single fwrite once flushThreshold bytes are pending, so large scans do not pay for a flush per line.
+class NdjsonWriter final {
+public:
+  explicit NdjsonWriter(FILE* file, size_t flushThreshold = 1 << 20);
+  ~NdjsonWriter();
+
+  NdjsonWriter(const NdjsonWriter&) = delete;
+  NdjsonWriter& operator=(const NdjsonWriter&) = delete;
+
+  // record must be a complete JSON value without a trailing newline
+  void Write(const std::string& record);
+  void Flush();
+
+private:
+  void FlushLocked();
+
+  FILE* mFile;
+  size_t mFlushThreshold;
+  std::string mBuffer;
+  std::mutex mMutex;
+};
+
+} // namespace utils
+} // namespace sample
+
+#endif // SAMPLES_COMMON_NDJSON_WRITER_H_
@@ -0,0 +1,156 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "parallel_crypto_pipeline.h"
+
+#include <future>
+#include <stdexcept>
+
+using mip::ProtectionHandler;
+using std::future;
+using std::make_shared;
+using std::promise;
+using std::runtime_error;
+using std::shared_ptr;
+using std::vector;
+
+namespace sample {
+namespace utils {
+
+const int64_t ParallelCryptoPipeline::kDefaultChunkSize;
+
+ParallelCryptoPipeline::ParallelCryptoPipeline(
+    const shared_ptr<ProtectionHandler>& protectionHandler,
+    ThreadPool& threadPool,
+    int64_t chunkSize)
+    : mProtectionHandler(protectionHandler),
+      mThreadPool(threadPool) {
+  // Chunks other than the last one must not split a cipher block
+  const int64_t blockSize = mProtectionHandler->GetBlockSize();
+  mChunkSize = blockSize > 0 ? (chunkSize / blockSize) * blockSize : chunkSize;
+  if (mChunkSize < blockSize)
+    mChunkSize = blockSize;
+  if (mChunkSize <= 0)
+    throw runtime_error("Invalid chunk size");
+  if (mProtectionHandler->GetProtectedContentLength(mChunkSize, false) != mChunkSize)
+    throw runtime_error("Cipher mode does not support independent chunks");
+}
+
+int64_t ParallelCryptoPipeline::GetEncryptedSize(int64_t cleartextSize) const {
+  if (cleartextSize <= mChunkSize)
+    return mProtectionHandler->GetProtectedContentLength(cleartextSize, true);
+
+  const int64_t lastChunkSize = cleartextSize - ((cleartextSize - 1) / mChunkSize) * mChunkSize;
+  const int64_t leadingSize = cleartextSize - lastChunkSize;
+  return mProtectionHandler->GetProtectedContentLength(leadingSize, false) +
+      mProtectionHandler->GetProtectedContentLength(lastChunkSize, true);
+}
+
+int64_t ParallelCryptoPipeline::Encrypt(const uint8_t* input, int64_t inputSize, uint8_t* output, int64_t outputSize) const {
+  if (outputSize < GetEncryptedSize(inputSize))
+    throw runtime_error("Output buffer too small for encrypted content");
+  return Run(true, input, inputSize, output, outputSize);
+}
+
+int64_t ParallelCryptoPipeline::Decrypt(const uint8_t* input, int64_t inputSize, uint8_t* output, int64_t outputSize) const {
+  if (outputSize < inputSize)
+    throw runtime_error("Output buffer too small for decrypted content");
+  return Run(false, input, inputSize, output, outputSize);
+}
+
+vector<uint8_t> ParallelCryptoPipeline::Encrypt(const vector<uint8_t>& cleartext) const {
+  vector<uint8_t> ciphertext(static_cast<size_t>(GetEncryptedSize(static_cast<int64_t>(cleartext.size()))));
+  auto size = Encrypt(cleartext.data(), static_cast<int64_t>(cleartext.size()), ciphertext.data(),
+      static_cast<int64_t>(ciphertext.size()));
+  ciphertext.resize(static_cast<size_t>(size));
+  return ciphertext;
+}
+
+vector<uint8_t> ParallelCryptoPipeline::Decrypt(const vector<uint8_t>& ciphertext) const {
+  vector<uint8_t> cleartext(ciphertext.size());
+  auto size = Decrypt(ciphertext.data(), static_cast<int64_t>(ciphertext.size()), cleartext.data(),
+      static_cast<int64_t>(cleartext.size()));
+  cleartext.resize(static_cast<size_t>(size));
+  return cleartext;
+}
+
+// Non-final chunks map to output ranges of the same size (block ciphers only grow the final block through padding),
+// so every chunk knows where to write without waiting for the chunks before it. Only the final chunk's result
+// determines the total length.
+int64_t ParallelCryptoPipeline::Run(
+    bool encrypt,
+    const uint8_t* input,
+    int64_t inputSize,
+    uint8_t* output,
+    int64_t outputSize) const {
+  const int64_t chunkCount = inputSize > 0 ? (inputSize + mChunkSize - 1) / mChunkSize : 1;
+  const int64_t lastOffset = (chunkCount - 1) * mChunkSize;
+  auto protectionHandler = mProtectionHandler;
+
+  vector<future<int64_t>> results;
+  results.reserve(static_cast<size_t>(chunkCount));
+  for (int64_t index = 0; index < chunkCount; index++) {
+    const int64_t offset = index * mChunkSize;
+    const bool isFinal = index == chunkCount - 1;
+    const int64_t chunkSize = isFinal ? inputSize - offset : mChunkSize;
+    const int64_t chunkOutputSize = isFinal ? outputSize - offset : mChunkSize;
+
+    auto chunkPromise = make_shared<promise<int64_t>>();
+    results.push_back(chunkPromise->get_future());
+    mThreadPool.Submit([=]() {
+      try {
+        int64_t written = encrypt ?
+            protectionHandler->EncryptBuffer(offset, input + offset, chunkSize, output + offset, chunkOutputSize, isFinal) :
+            protectionHandler->DecryptBuffer(offset, input + offset, chunkSize, output + offset, chunkOutputSize, isFinal);
+        if (!isFinal && written != chunkSize)
+          throw runtime_error("Unexpected size of non-final protected chunk");
+        chunkPromise->set_value(written);
+      } catch (...) {
+        chunkPromise->set_exception(std::current_exception());
+      }
+    });
+  }
+
+  // Wait for every chunk before surfacing the first failure: the tasks reference the caller's buffers
+  int64_t finalSize = 0;
+  std::exception_ptr error;
+  for (auto& result : results) {
+    try {
+      finalSize = result.get();
+    } catch (...) {
+      if (!error)
+        error = std::current_exception();
+    }
+  }
+  if (error)
+    std::rethrow_exception(error);
+
+  return lastOffset + finalSize;
+}
+
+} // namespace utils
+} // namespace sample
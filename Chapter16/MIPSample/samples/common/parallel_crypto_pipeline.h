@@ -0,0 +1,83 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_PARALLEL_CRYPTO_PIPELINE_H_
+#define SAMPLES_COMMON_PARALLEL_CRYPTO_PIPELINE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mip/protection/protection_handler.h"
+#include "thread_pool.h"
+
+namespace sample {
+namespace utils {
+
+// Encrypts/decrypts large payloads with a ProtectionHandler by splitting them into chunks on cipher block boundaries
+// and running ProtectionHandler::EncryptBuffer/DecryptBuffer for the chunks concurrently on a ThreadPool. Every chunk
+// carries its own offsetFromStart and only the last one is marked final, so the output is identical to a single
+// sequential call.
+//
+// The pool must not be the one the caller is running on: the pipeline blocks until all of its chunks are done.
+class ParallelCryptoPipeline final {
+public:
+  static const int64_t kDefaultChunkSize = 4 * 1024 * 1024;
+
+  ParallelCryptoPipeline(
+      const std::shared_ptr<mip::ProtectionHandler>& protectionHandler,
+      ThreadPool& threadPool,
+      int64_t chunkSize = kDefaultChunkSize);
+
+  // Size of the buffer needed to encrypt cleartextSize bytes.
+  int64_t GetEncryptedSize(int64_t cleartextSize) const;
+
+  // Encrypts input into output, which must hold at least GetEncryptedSize(inputSize) bytes.
+  // Returns the number of encrypted bytes written.
+  int64_t Encrypt(const uint8_t* input, int64_t inputSize, uint8_t* output, int64_t outputSize) const;
+
+  // Decrypts input into output, which must hold at least inputSize bytes.
+  // Returns the number of cleartext bytes written.
+  int64_t Decrypt(const uint8_t* input, int64_t inputSize, uint8_t* output, int64_t outputSize) const;
+
+  std::vector<uint8_t> Encrypt(const std::vector<uint8_t>& cleartext) const;
+  std::vector<uint8_t> Decrypt(const std::vector<uint8_t>& ciphertext) const;
+
+  int64_t GetChunkSize() const { return mChunkSize; }
+
+private:
+  int64_t Run(bool encrypt, const uint8_t* input, int64_t inputSize, uint8_t* output, int64_t outputSize) const;
+
+  std::shared_ptr<mip::ProtectionHandler> mProtectionHandler;
+  ThreadPool& mThreadPool;
+  int64_t mChunkSize;
+};
+
+} // namespace utils
+} // namespace sample
+
+#endif // SAMPLES_COMMON_PARALLEL_CRYPTO_PIPELINE_H_
@@ -0,0 +1,191 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include "pooled_execution_state.h"
+
+#include <limits>
+#include <stdexcept>
+
+using mip::ActionSource;
+using mip::ActionType;
+using mip::AssignmentMethod;
+using mip::ClassificationResult;
+using std::map;
+using std::pair;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace sample {
+namespace upe {
+
+namespace {
+
+const ActionType kDefaultSupportedActions =
+    ActionType::METADATA | ActionType::PROTECT_ADHOC | ActionType::PROTECT_BY_TEMPLATE |
+    ActionType::PROTECT_DO_NOT_FORWARD | ActionType::REMOVE_PROTECTION | ActionType::JUSTIFY;
+
+bool StartsWith(const string& str, const string& prefix) {
+  return str.size() >= prefix.size() && str.compare(0, prefix.size(), prefix) == 0;
+}
+
+} // namespace
+
+PooledExecutionState::PooledExecutionState() {
+  Reset();
+}
+
+void PooledExecutionState::Reset() {
+  // clear() keeps the capacity of strings and vectors
+  mNewLabelId.clear();
+  mAssignmentMethod = AssignmentMethod::STANDARD;
+  mActionSource = ActionSource::MANUAL;
+  mContentIdentifier.clear();
+  mContentState = mip::ContentState::REST;
+  mContentFormat = mip::ContentFormat::DEFAULT;
+  mIsDowngradeJustified = false;
+  mJustificationMessage.clear();
+  mDescriptor.reset();
+  mSupportedActions = kDefaultSupportedActions;
+  mClassification.reset();
+  mAuditMetadata.clear();
+  mArena.clear();
+  mMetadata.clear();
+  mExtendedProperties.clear();
+}
+
+void PooledExecutionState::SetNewLabel(const string& labelId, AssignmentMethod method, ActionSource actionSource) {
+  mNewLabelId = labelId;
+  mAssignmentMethod = method;
+  mActionSource = actionSource;
+}
+
+void PooledExecutionState::SetDowngradeJustification(bool isJustified, const string& justificationMessage) {
+  mIsDowngradeJustified = isJustified;
+  mJustificationMessage = justificationMessage;
+}
+
+void PooledExecutionState::AddNewLabelExtendedProperty(const string& key, const string& value) {
+  const Slice storedKey = Store(key);
+  mExtendedProperties.push_back(Entry{ storedKey, Store(value) });
+}
+
+void PooledExecutionState::AddContentMetadata(const string& name, const string& value) {
+  const size_t index = LowerBound(name);
+  if (index < mMetadata.size() && CompareName(mMetadata[index], name, false) == 0) {
+    // The old value stays in the arena until Reset
+    mMetadata[index].value = Store(value);
+    return;
+  }
+  const Slice storedName = Store(name);
+  mMetadata.insert(mMetadata.begin() + index, Entry{ storedName, Store(value) });
+}
+
+pair<bool, string> PooledExecutionState::IsDowngradeJustified() const {
+  return pair<bool, string>(mIsDowngradeJustified, mJustificationMessage);
+}
+
+vector<pair<string, string>> PooledExecutionState::GetNewLabelExtendedProperties() const {
+  vector<pair<string, string>> properties;
+  properties.reserve(mExtendedProperties.size());
+  for (const auto& entry : mExtendedProperties)
+    properties.emplace_back(Get(entry.name), Get(entry.value));
+  return properties;
+}
+
+vector<pair<string, string>> PooledExecutionState::GetContentMetadata(
+    const vector<string>& names,
+    const vector<string>& namePrefixes) const {
+  vector<pair<string, string>> metadata;
+
+  // A prefix that extends another requested prefix selects a subrange of it, skip it to avoid duplicates
+  auto isCoveredByOtherPrefix = [&namePrefixes](const string& str, size_t self) {
+    for (size_t i = 0; i < namePrefixes.size(); i++) {
+      if (i != self && StartsWith(str, namePrefixes[i]) &&
+          (namePrefixes[i].size() < str.size() || i < self))
+        return true;
+    }
+    return false;
+  };
+
+  for (size_t p = 0; p < namePrefixes.size(); p++) {
+    const string& prefix = namePrefixes[p];
+    if (isCoveredByOtherPrefix(prefix, p))
+      continue;
+    for (size_t i = LowerBound(prefix); i < mMetadata.size() && CompareName(mMetadata[i], prefix, true) == 0; i++)
+      metadata.emplace_back(Get(mMetadata[i].name), Get(mMetadata[i].value));
+  }
+
+  for (const auto& name : names) {
+    if (isCoveredByOtherPrefix(name, namePrefixes.size()))
+      continue;
+    const size_t index = LowerBound(name);
+    if (index < mMetadata.size() && CompareName(mMetadata[index], name, false) == 0)
+      metadata.emplace_back(Get(mMetadata[index].name), Get(mMetadata[index].value));
+  }
+  return metadata;
+}
+
+ActionType PooledExecutionState::GetSupportedActions() const {
+  return mSupportedActions | ActionType::JUSTIFY;
+}
+
+map<string, shared_ptr<ClassificationResult>> PooledExecutionState::GetClassificationResults(
+    const vector<string>& classificationIds) const {
+  if (!mClassification)
+    return map<string, shared_ptr<ClassificationResult>>();
+  return mClassification->GetResults(classificationIds);
+}
+
+PooledExecutionState::Slice PooledExecutionState::Store(const string& str) {
+  if (mArena.size() + str.size() > std::numeric_limits<uint32_t>::max())
+    throw std::length_error("Execution state metadata is too large");
+  const Slice slice = { static_cast<uint32_t>(mArena.size()), static_cast<uint32_t>(str.size()) };
+  mArena.append(str);
+  return slice;
+}
+
+int PooledExecutionState::CompareName(const Entry& entry, const string& str, bool asPrefix) const {
+  if (asPrefix && entry.name.length >= str.size())
+    return mArena.compare(entry.name.offset, str.size(), str);
+  return mArena.compare(entry.name.offset, entry.name.length, str);
+}
+
+size_t PooledExecutionState::LowerBound(const string& str) const {
+  size_t low = 0;
+  size_t high = mMetadata.size();
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    if (CompareName(mMetadata[middle], str, false) < 0)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low;
+}
+
+} // namespace upe
+} // namespace sample
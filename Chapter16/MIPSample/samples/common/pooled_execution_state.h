@@ -0,0 +1,138 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef SAMPLES_COMMON_POOLED_EXECUTION_STATE_H_
+#define SAMPLES_COMMON_POOLED_EXECUTION_STATE_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "content_classifier.h"
+#include "mip/common_types.h"
+#include "mip/protection_descriptor.h"
+#include "mip/upe/execution_state.h"
+
+namespace sample {
+namespace upe {
+
+// mip::ExecutionState meant to be reused for item after item when calling PolicyHandler::ComputeActions directly.
+//
+// Reset() clears the state but keeps every buffer, so after the first few items filling in the state allocates
+// nothing. Metadata names and values live in one character arena; entries are kept sorted by name, so
+// GetContentMetadata finds names by binary search and prefixes as one contiguous range. The vectors returned by the
+// ExecutionState interface are still built per call, since the interface returns them by value.
+//
+// Not thread-safe: fill in and evaluate one item at a time, or use one state per thread.
+class PooledExecutionState final : public mip::ExecutionState {
+public:
+  PooledExecutionState();
+
+  PooledExecutionState(const PooledExecutionState&) = delete;
+  PooledExecutionState& operator=(const PooledExecutionState&) = delete;
+
+  // Back to the defaults of a new state, keeping the allocated capacity
+  void Reset();
+
+  void SetNewLabel(const std::string& labelId, mip::AssignmentMethod method, mip::ActionSource actionSource);
+  void SetContentIdentifier(const std::string& contentIdentifier) { mContentIdentifier = contentIdentifier; }
+  void SetContentState(mip::ContentState contentState) { mContentState = contentState; }
+  void SetContentFormat(mip::ContentFormat contentFormat) { mContentFormat = contentFormat; }
+  void SetDowngradeJustification(bool isJustified, const std::string& justificationMessage);
+  void SetProtectionDescriptor(const std::shared_ptr<mip::ProtectionDescriptor>& descriptor) { mDescriptor = descriptor; }
+  // Defaults to metadata and protection changes, which a batch labeler can carry out without editing the content.
+  // JUSTIFY is always added, the SDK requires it.
+  void SetSupportedActions(mip::ActionType supportedActions) { mSupportedActions = supportedActions; }
+  void AddNewLabelExtendedProperty(const std::string& key, const std::string& value);
+  // Replaces the value if name is already set
+  void AddContentMetadata(const std::string& name, const std::string& value);
+  // Answers GetClassificationResults, typically from ContentClassifier::Scan of the item
+  void SetClassification(const std::shared_ptr<const classification::ContentClassification>& classification) {
+    mClassification = classification;
+  }
+  void AddAuditMetadata(const std::string& key, const std::string& value) { mAuditMetadata[key] = value; }
+
+  std::string GetNewLabelId() const override { return mNewLabelId; }
+  mip::ActionSource GetNewLabelActionSource() const override { return mActionSource; }
+  std::string GetContentIdentifier() const override { return mContentIdentifier; }
+  mip::ContentState GetContentState() const override { return mContentState; }
+  std::pair<bool, std::string> IsDowngradeJustified() const override;
+  mip::AssignmentMethod GetNewLabelAssignmentMethod() const override { return mAssignmentMethod; }
+  std::vector<std::pair<std::string, std::string>> GetNewLabelExtendedProperties() const override;
+  std::vector<std::pair<std::string, std::string>> GetContentMetadata(
+      const std::vector<std::string>& names,
+      const std::vector<std::string>& namePrefixes) const override;
+  std::shared_ptr<mip::ProtectionDescriptor> GetProtectionDescriptor() const override { return mDescriptor; }
+  mip::ContentFormat GetContentFormat() const override { return mContentFormat; }
+  mip::ActionType GetSupportedActions() const override;
+  std::map<std::string, std::shared_ptr<mip::ClassificationResult>> GetClassificationResults(
+      const std::vector<std::string>& classificationIds) const override;
+  std::map<std::string, std::string> GetAuditMetadata() const override { return mAuditMetadata; }
+
+private:
+  // A string stored in mArena
+  struct Slice {
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  struct Entry {
+    Slice name;
+    Slice value;
+  };
+
+  Slice Store(const std::string& str);
+  std::string Get(const Slice& slice) const { return mArena.substr(slice.offset, slice.length); }
+  // Three-way comparison of the stored name with str, or of its first str.size() characters when asPrefix is set
+  int CompareName(const Entry& entry, const std::string& str, bool asPrefix) const;
+  // First entry whose name is not less than str
+  size_t LowerBound(const std::string& str) const;
+
+  std::string mNewLabelId;
+  mip::AssignmentMethod mAssignmentMethod;
+  mip::ActionSource mActionSource;
+  std::string mContentIdentifier;
+  mip::ContentState mContentState;
+  mip::ContentFormat mContentFormat;
+  bool mIsDowngradeJustified;
+  std::string mJustificationMessage;
+  std::shared_ptr<mip::ProtectionDescriptor> mDescriptor;
+  mip::ActionType mSupportedActions;
+  std::shared_ptr<const classification::ContentClassification> mClassification;
+  std::map<std::string, std::string> mAuditMetadata;
+
+  std::string mArena;
+  std::vector<Entry> mMetadata; // Sorted by name
+  std::vector<Entry> mExtendedProperties; // In the order added
+};
+
+} // namespace upe
+} // namespace sample
+
+#endif // SAMPLES_COMMON_POOLED_EXECUTION_STATE_H_
@@ -0,0 +1,198 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "pooled_http_delegate.h"
+
+#include <chrono>
+#include <curl/curl.h>
+
+#include "http_message_impl.h"
+#include "mip/error.h"
+
+using mip::HttpRequest;
+using mip::HttpRequestType;
+using mip::HttpResponse;
+using std::lock_guard;
+using std::make_shared;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::unique_lock;
+
+namespace {
+
+void InitializeCurlOnce() {
+  // curl_global_init is not thread-safe; do it exactly once before any handle exists
+  static std::once_flag initialized;
+  std::call_once(initialized, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+// "scheme://host[:port]" of url, which is the unit connections can be reused for
+string GetHostKey(const string& url) {
+  auto schemeEnd = url.find("://");
+  auto hostStart = schemeEnd == string::npos ? 0 : schemeEnd + 3;
+  auto hostEnd = url.find_first_of("/?#", hostStart);
+  return url.substr(0, hostEnd);
+}
+
+size_t OnBody(char* data, size_t size, size_t count, void* userData) {
+  static_cast<string*>(userData)->append(data, size * count);
+  return size * count;
+}
+
+size_t OnHeader(char* data, size_t size, size_t count, void* userData) {
+  auto headers = static_cast<sample::http::HttpHeaders*>(userData);
+  string line(data, size * count);
+
+  // A new status line starts a new header block (e.g. after '100 Continue')
+  if (line.compare(0, 5, "HTTP/") == 0) {
+    headers->clear();
+    return size * count;
+  }
+
+  auto separator = line.find(':');
+  if (separator != string::npos) {
+    auto valueStart = line.find_first_not_of(" \t", separator + 1);
+    auto valueEnd = line.find_last_not_of("\r\n \t");
+    string value = (valueStart == string::npos || valueEnd < valueStart) ?
+        string() : line.substr(valueStart, valueEnd - valueStart + 1);
+    // The SDK sees one value per name, so repeated headers are combined into a list as RFC 7230 allows
+    auto inserted = headers->insert(std::make_pair(line.substr(0, separator), value));
+    if (!inserted.second)
+      inserted.first->second += ", " + value;
+  }
+  return size * count;
+}
+
+} // namespace
+
+namespace sample {
+namespace http {
+
+PooledHttpDelegate::PooledHttpDelegate(size_t maxConnectionsPerHost, long timeoutSeconds)
+    : mMaxConnectionsPerHost(maxConnectionsPerHost > 0 ? maxConnectionsPerHost : 1),
+      mTimeoutSeconds(timeoutSeconds),
+      mConnectionCount(0) {
+  InitializeCurlOnce();
+}
+
+PooledHttpDelegate::~PooledHttpDelegate() {
+  for (auto& hostPool : mHostPools) {
+    for (auto handle : hostPool.second.idleHandles)
+      curl_easy_cleanup(static_cast<CURL*>(handle));
+  }
+}
+
+size_t PooledHttpDelegate::GetConnectionCount() const {
+  lock_guard<mutex> lock(mMutex);
+  return mConnectionCount;
+}
+
+void* PooledHttpDelegate::AcquireHandle(const string& host) {
+  unique_lock<mutex> lock(mMutex);
+  HostPool& hostPool = mHostPools[host];
+  mHandleReleased.wait(lock, [&] {
+    return !hostPool.idleHandles.empty() || hostPool.handleCount < mMaxConnectionsPerHost;
+  });
+
+  if (!hostPool.idleHandles.empty()) {
+    void* handle = hostPool.idleHandles.back();
+    hostPool.idleHandles.pop_back();
+    return handle;
+  }
+
+  CURL* handle = curl_easy_init();
+  if (handle == nullptr)
+    throw mip::NetworkError("Failed to create HTTP connection");
+  hostPool.handleCount++;
+  mConnectionCount++;
+  return handle;
+}
+
+void PooledHttpDelegate::ReleaseHandle(const string& host, void* handle) {
+  {
+    lock_guard<mutex> lock(mMutex);
+    mHostPools[host].idleHandles.push_back(handle);
+  }
+  mHandleReleased.notify_all();
+}
+
+shared_ptr<HttpResponse> PooledHttpDelegate::Send(
+    const shared_ptr<HttpRequest>& request,
+    const shared_ptr<void>& /*context*/) {
+  const string host = GetHostKey(request->GetUrl());
+  CURL* handle = static_cast<CURL*>(AcquireHandle(host));
+
+  // Reset clears the options of the previous request but keeps the handle's open connection
+  curl_easy_reset(handle);
+
+  struct curl_slist* headerList = nullptr;
+  for (const auto& header : request->GetHeaders())
+    headerList = curl_slist_append(headerList, (header.first + ": " + header.second).c_str());
+
+  string body;
+  HttpHeaders responseHeaders;
+  curl_easy_setopt(handle, CURLOPT_URL, request->GetUrl().c_str());
+  curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headerList);
+  curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(handle, CURLOPT_TIMEOUT, mTimeoutSeconds);
+  curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "");
+  curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, OnBody);
+  curl_easy_setopt(handle, CURLOPT_WRITEDATA, &body);
+  curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, OnHeader);
+  curl_easy_setopt(handle, CURLOPT_HEADERDATA, &responseHeaders);
+  if (request->GetRequestType() == HttpRequestType::Post) {
+    curl_easy_setopt(handle, CURLOPT_POST, 1L);
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDS, request->GetBody().c_str());
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(request->GetBody().size()));
+  } else {
+    curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  CURLcode result = curl_easy_perform(handle);
+  mLatency.Record(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+  long statusCode = 0;
+  curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &statusCode);
+  curl_slist_free_all(headerList);
+  ReleaseHandle(host, handle);
+
+  if (result != CURLE_OK) {
+    const string message = string("HTTP request to ") + host + " failed: " + curl_easy_strerror(result);
+    if (result == CURLE_OPERATION_TIMEDOUT || result == CURLE_COULDNT_CONNECT ||
+        result == CURLE_SEND_ERROR || result == CURLE_RECV_ERROR || result == CURLE_GOT_NOTHING)
+      throw mip::TransientNetworkError(message);
+    throw mip::NetworkError(message);
+  }
+
+  return make_shared<HttpResponseImpl>(static_cast<int32_t>(statusCode), body, responseHeaders);
+}
+
+} // namespace http
+} // namespace sample
@@ -0,0 +1,91 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_POOLED_HTTP_DELEGATE_H_
+#define SAMPLES_COMMON_POOLED_HTTP_DELEGATE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mip/http_delegate.h"
+#include "latency_recorder.h"
+
+namespace sample {
+namespace http {
+
+// mip::HttpDelegate built on libcurl that keeps persistent (keep-alive) connections per host.
+//
+// Every host ("scheme://host:port") gets its own pool of curl handles. A handle keeps its connection open between
+// requests, so consecutive policy/license/token calls to the same service skip the TCP and TLS handshakes. At most
+// maxConnectionsPerHost requests run concurrently against one host; further callers wait for a handle to be released.
+//
+// Transport failures are reported as mip::TransientNetworkError (timeouts, refused connections) or mip::NetworkError.
+class PooledHttpDelegate final : public mip::HttpDelegate {
+public:
+  explicit PooledHttpDelegate(size_t maxConnectionsPerHost = 8, long timeoutSeconds = 60);
+  ~PooledHttpDelegate();
+
+  PooledHttpDelegate(const PooledHttpDelegate&) = delete;
+  PooledHttpDelegate& operator=(const PooledHttpDelegate&) = delete;
+
+  std::shared_ptr<mip::HttpResponse> Send(
+      const std::shared_ptr<mip::HttpRequest>& request,
+      const std::shared_ptr<void>& context) override;
+
+  // Latency of every completed request, including failed ones
+  sample::utils::LatencySummary GetLatencySummary() const { return mLatency.GetSummary(); }
+
+  // Number of connections (curl handles) opened over the lifetime of the delegate
+  size_t GetConnectionCount() const;
+
+private:
+  struct HostPool {
+    std::vector<void*> idleHandles;
+    size_t handleCount = 0;
+  };
+
+  void* AcquireHandle(const std::string& host);
+  void ReleaseHandle(const std::string& host, void* handle);
+
+  size_t mMaxConnectionsPerHost;
+  long mTimeoutSeconds;
+  std::map<std::string, HostPool> mHostPools;
+  size_t mConnectionCount;
+  mutable std::mutex mMutex;
+  std::condition_variable mHandleReleased;
+  sample::utils::LatencyRecorder mLatency;
+};
+
+} // namespace http
+} // namespace sample
+
+#endif // SAMPLES_COMMON_POOLED_HTTP_DELEGATE_H_
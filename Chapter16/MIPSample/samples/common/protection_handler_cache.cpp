@@ -0,0 +1,161 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "protection_handler_cache.h"
+
+#include <stdexcept>
+
+#include "mip/protection/protection_profile.h"
+
+using mip::ProtectionEngine;
+using mip::ProtectionHandler;
+using mip::ProtectionHandlerCreationOptions;
+using mip::ProtectionProfile;
+using std::chrono::system_clock;
+using std::lock_guard;
+using std::mutex;
+using std::promise;
+using std::shared_future;
+using std::shared_ptr;
+using std::string;
+using std::unique_lock;
+using std::vector;
+
+namespace sample {
+namespace utils {
+
+ProtectionHandlerCache::ProtectionHandlerCache(
+    const shared_ptr<ProtectionEngine>& protectionEngine,
+    size_t capacity,
+    ProtectionHandlerCreationOptions options)
+  : mProtectionEngine(protectionEngine),
+    mCapacity(capacity),
+    mOptions(options),
+    mHits(0),
+    mMisses(0) {
+  if (!mProtectionEngine)
+    throw std::invalid_argument("ProtectionHandlerCache requires a protection engine");
+  if (mCapacity == 0)
+    throw std::invalid_argument("ProtectionHandlerCache capacity must be positive");
+}
+
+shared_ptr<ProtectionHandler> ProtectionHandlerCache::GetForPublishingLicense(
+    const vector<uint8_t>& serializedPublishingLicense) {
+  // The license bytes are the key; the hash map only compares them in full on a hash match
+  const string key(serializedPublishingLicense.begin(), serializedPublishingLicense.end());
+
+  unique_lock<mutex> lock(mMutex);
+  auto found = mLookup.find(key);
+  if (found != mLookup.end()) {
+    const Entry& entry = *found->second;
+    const bool expired = entry.validUntil != system_clock::time_point() && system_clock::now() >= entry.validUntil;
+    if (!expired) {
+      mEntries.splice(mEntries.begin(), mEntries, found->second);
+      mHits++;
+      return entry.handler;
+    }
+    mEntries.erase(found->second);
+    mLookup.erase(found);
+  }
+
+  auto pending = mPending.find(key);
+  if (pending != mPending.end()) {
+    // Another thread is already acquiring this license
+    shared_future<shared_ptr<ProtectionHandler>> creation = pending->second;
+    mHits++;
+    lock.unlock();
+    return creation.get();
+  }
+
+  mMisses++;
+  promise<shared_ptr<ProtectionHandler>> created;
+  mPending[key] = created.get_future().share();
+  lock.unlock();
+
+  // Whatever fails, including reading the descriptor for Insert, must reach the threads waiting on created
+  shared_ptr<ProtectionHandler> handler;
+  try {
+    handler = Create(serializedPublishingLicense);
+    lock.lock();
+    mPending.erase(key);
+    Insert(key, handler);
+    lock.unlock();
+  } catch (...) {
+    if (!lock.owns_lock())
+      lock.lock();
+    mPending.erase(key);
+    lock.unlock();
+    created.set_exception(std::current_exception());
+    throw;
+  }
+
+  created.set_value(handler);
+  return handler;
+}
+
+shared_ptr<ProtectionHandler> ProtectionHandlerCache::Create(const vector<uint8_t>& serializedPublishingLicense) {
+  const auto publishingLicenseContext = ProtectionProfile::GetPublishingLicenseContext(serializedPublishingLicense);
+  return mProtectionEngine->CreateProtectionHandlerFromPublishingLicenseContext(
+      publishingLicenseContext, mOptions, nullptr /*context*/);
+}
+
+// Must be called with mMutex held
+void ProtectionHandlerCache::Insert(const string& key, const shared_ptr<ProtectionHandler>& handler) {
+  Entry entry;
+  entry.key = key;
+  entry.handler = handler;
+  const auto descriptor = handler->GetProtectionDescriptor();
+  if (descriptor)
+    entry.validUntil = descriptor->GetContentValidUntil();
+
+  mEntries.push_front(entry);
+  mLookup[key] = mEntries.begin();
+
+  while (mEntries.size() > mCapacity) {
+    mLookup.erase(mEntries.back().key);
+    mEntries.pop_back();
+  }
+}
+
+void ProtectionHandlerCache::Clear() {
+  lock_guard<mutex> lock(mMutex);
+  mEntries.clear();
+  mLookup.clear();
+}
+
+size_t ProtectionHandlerCache::GetHitCount() const {
+  lock_guard<mutex> lock(mMutex);
+  return mHits;
+}
+
+size_t ProtectionHandlerCache::GetMissCount() const {
+  lock_guard<mutex> lock(mMutex);
+  return mMisses;
+}
+
+} // namespace utils
+} // namespace sample
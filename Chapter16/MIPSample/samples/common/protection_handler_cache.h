@@ -0,0 +1,97 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_PROTECTION_HANDLER_CACHE_H_
+#define SAMPLES_COMMON_PROTECTION_HANDLER_CACHE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mip/protection/protection_engine.h"
+#include "mip/protection/protection_handler.h"
+
+namespace sample {
+namespace utils {
+
+// LRU cache of ProtectionHandlers for consuming protected content, keyed by the serialized publishing license.
+// Documents protected with the same template or descriptor share a publishing license, so a batch of them needs one
+// use license round-trip instead of one per document.
+//
+// - Concurrent requests for a license that is not cached share a single handler creation.
+// - A handler is not served past the GetContentValidUntil of its descriptor; the next request creates a new one.
+// - Failed creations are not cached.
+class ProtectionHandlerCache final {
+public:
+  ProtectionHandlerCache(
+      const std::shared_ptr<mip::ProtectionEngine>& protectionEngine,
+      size_t capacity,
+      mip::ProtectionHandlerCreationOptions options = mip::ProtectionHandlerCreationOptions::None);
+
+  ProtectionHandlerCache(const ProtectionHandlerCache&) = delete;
+  ProtectionHandlerCache& operator=(const ProtectionHandlerCache&) = delete;
+
+  std::shared_ptr<mip::ProtectionHandler> GetForPublishingLicense(const std::vector<uint8_t>& serializedPublishingLicense);
+
+  void Clear();
+
+  size_t GetHitCount() const;
+  size_t GetMissCount() const;
+
+private:
+  struct Entry {
+    std::string key;
+    std::shared_ptr<mip::ProtectionHandler> handler;
+    std::chrono::system_clock::time_point validUntil; // Epoch if the content does not expire
+  };
+
+  std::shared_ptr<mip::ProtectionHandler> Create(const std::vector<uint8_t>& serializedPublishingLicense);
+  void Insert(const std::string& key, const std::shared_ptr<mip::ProtectionHandler>& handler);
+
+  std::shared_ptr<mip::ProtectionEngine> mProtectionEngine;
+  size_t mCapacity;
+  mip::ProtectionHandlerCreationOptions mOptions;
+
+  mutable std::mutex mMutex;
+  std::list<Entry> mEntries; // Most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> mLookup;
+  std::unordered_map<std::string, std::shared_future<std::shared_ptr<mip::ProtectionHandler>>> mPending;
+  size_t mHits;
+  size_t mMisses;
+};
+
+} // namespace utils
+} // namespace sample
+
+#endif // SAMPLES_COMMON_PROTECTION_HANDLER_CACHE_H_
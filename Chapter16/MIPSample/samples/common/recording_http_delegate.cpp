@@ -0,0 +1,79 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "recording_http_delegate.h"
+
+#include <stdexcept>
+
+#include "http_exchange_log.h"
+#include "string_utils.h"
+
+using mip::HttpDelegate;
+using mip::HttpRequest;
+using mip::HttpResponse;
+using std::lock_guard;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+
+namespace sample {
+namespace http {
+
+RecordingHttpDelegate::RecordingHttpDelegate(const shared_ptr<HttpDelegate>& innerDelegate, const string& logPath)
+    : mInnerDelegate(innerDelegate),
+      mLog(FILENAME_STRING(logPath), std::ios::binary | std::ios::trunc) {
+  if (!mInnerDelegate)
+    throw std::invalid_argument("RecordingHttpDelegate requires an inner HttpDelegate");
+  if (mLog.fail())
+    throw std::runtime_error("Failed to open HTTP recording: " + logPath);
+}
+
+shared_ptr<HttpResponse> RecordingHttpDelegate::Send(
+    const shared_ptr<HttpRequest>& request,
+    const shared_ptr<void>& context) {
+  auto response = mInnerDelegate->Send(request, context);
+
+  HttpExchange exchange;
+  exchange.type = request->GetRequestType();
+  exchange.url = request->GetUrl();
+  exchange.requestHeaders = request->GetHeaders();
+  exchange.requestBody = request->GetBody();
+  if (response) {
+    exchange.statusCode = response->GetStatusCode();
+    exchange.responseHeaders = response->GetHeaders();
+    exchange.responseBody = response->GetBody();
+  }
+
+  lock_guard<mutex> lock(mMutex);
+  WriteHttpExchange(mLog, exchange);
+  // Flush per exchange so a recording survives the process being killed mid-run
+  mLog.flush();
+  return response;
+}
+
+} // namespace http
+} // namespace sample
@@ -0,0 +1,64 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_RECORDING_HTTP_DELEGATE_H_
+#define SAMPLES_COMMON_RECORDING_HTTP_DELEGATE_H_
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "mip/http_delegate.h"
+
+namespace sample {
+namespace http {
+
+// mip::HttpDelegate that forwards every request to another delegate and appends the request and its response to an
+// HTTP exchange log (see http_exchange_log.h), for later use with ReplayHttpDelegate. Requests that fail in the
+// inner delegate are not recorded.
+class RecordingHttpDelegate final : public mip::HttpDelegate {
+public:
+  RecordingHttpDelegate(const std::shared_ptr<mip::HttpDelegate>& innerDelegate, const std::string& logPath);
+
+  RecordingHttpDelegate(const RecordingHttpDelegate&) = delete;
+  RecordingHttpDelegate& operator=(const RecordingHttpDelegate&) = delete;
+
+  std::shared_ptr<mip::HttpResponse> Send(
+      const std::shared_ptr<mip::HttpRequest>& request,
+      const std::shared_ptr<void>& context) override;
+
+private:
+  std::shared_ptr<mip::HttpDelegate> mInnerDelegate;
+  std::ofstream mLog;
+  std::mutex mMutex;
+};
+
+} // namespace http
+} // namespace sample
+
+#endif // SAMPLES_COMMON_RECORDING_HTTP_DELEGATE_H_
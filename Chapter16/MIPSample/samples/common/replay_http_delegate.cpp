@@ -0,0 +1,93 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "replay_http_delegate.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include "http_exchange_log.h"
+#include "http_message_impl.h"
+#include "mip/error.h"
+#include "string_utils.h"
+
+using mip::HttpRequest;
+using mip::HttpResponse;
+using std::chrono::milliseconds;
+using std::ifstream;
+using std::make_shared;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::unique_lock;
+
+namespace sample {
+namespace http {
+
+ReplayHttpDelegate::ReplayHttpDelegate(const string& logPath, milliseconds latency)
+    : mExchangeCount(0),
+      mLatency(latency) {
+  ifstream log(FILENAME_STRING(logPath), std::ios::binary);
+  if (log.fail())
+    throw std::runtime_error("Failed to open HTTP recording: " + logPath);
+
+  HttpExchange exchange;
+  while (ReadHttpExchange(log, exchange)) {
+    const string key = GetHttpExchangeKey(exchange.type, exchange.url, exchange.requestBody);
+    mResponses[key].recorded.push_back(
+        make_shared<HttpResponseImpl>(exchange.statusCode, exchange.responseBody, exchange.responseHeaders));
+    mExchangeCount++;
+  }
+}
+
+shared_ptr<HttpResponse> ReplayHttpDelegate::Send(
+    const shared_ptr<HttpRequest>& request,
+    const shared_ptr<void>& /*context*/) {
+  const string key = GetHttpExchangeKey(request->GetRequestType(), request->GetUrl(), request->GetBody());
+
+  shared_ptr<HttpResponse> response;
+  {
+    unique_lock<mutex> lock(mMutex);
+    auto found = mResponses.find(key);
+    if (found == mResponses.end())
+      throw mip::NetworkError("No recorded response for " + request->GetUrl());
+
+    Responses& responses = found->second;
+    response = responses.recorded[responses.next];
+    if (responses.next + 1 < responses.recorded.size())
+      responses.next++;
+  }
+
+  // Sleep outside the lock so concurrent requests overlap their latency like real ones would
+  if (mLatency.count() > 0)
+    std::this_thread::sleep_for(mLatency);
+  return response;
+}
+
+} // namespace http
+} // namespace sample
@@ -0,0 +1,81 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_REPLAY_HTTP_DELEGATE_H_
+#define SAMPLES_COMMON_REPLAY_HTTP_DELEGATE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mip/http_delegate.h"
+#include "mip/http_response.h"
+
+namespace sample {
+namespace http {
+
+// mip::HttpDelegate that answers from an HTTP exchange log written by RecordingHttpDelegate, without any network
+// access. Requests are matched on type, URL and body through a hash map. When the same request was recorded several
+// times its responses are served in recorded order, and the last one is repeated once they run out.
+//
+// latency is added to every response to model a service of known speed. A request that was never recorded fails with
+// mip::NetworkError.
+class ReplayHttpDelegate final : public mip::HttpDelegate {
+public:
+  explicit ReplayHttpDelegate(
+      const std::string& logPath,
+      std::chrono::milliseconds latency = std::chrono::milliseconds(0));
+
+  ReplayHttpDelegate(const ReplayHttpDelegate&) = delete;
+  ReplayHttpDelegate& operator=(const ReplayHttpDelegate&) = delete;
+
+  std::shared_ptr<mip::HttpResponse> Send(
+      const std::shared_ptr<mip::HttpRequest>& request,
+      const std::shared_ptr<void>& context) override;
+
+  size_t GetExchangeCount() const { return mExchangeCount; }
+
+private:
+  struct Responses {
+    std::vector<std::shared_ptr<mip::HttpResponse>> recorded;
+    size_t next = 0;
+  };
+
+  std::unordered_map<std::string, Responses> mResponses;
+  size_t mExchangeCount;
+  std::chrono::milliseconds mLatency;
+  std::mutex mMutex;
+};
+
+} // namespace http
+} // namespace sample
+
+#endif // SAMPLES_COMMON_REPLAY_HTTP_DELEGATE_H_
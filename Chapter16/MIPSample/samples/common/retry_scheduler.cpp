@@ -0,0 +1,224 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include "retry_scheduler.h"
+
+#include "mip/error.h"
+
+using std::chrono::milliseconds;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::unique_lock;
+
+namespace sample {
+namespace utils {
+
+FailureKind ClassifyFailure(const std::exception& error) {
+  if (dynamic_cast<const mip::TransientNetworkError*>(&error) || dynamic_cast<const mip::PolicySyncError*>(&error))
+    return FailureKind::Transient;
+  if (dynamic_cast<const mip::NetworkError*>(&error))
+    return FailureKind::EndpointDown;
+  return FailureKind::Permanent;
+}
+
+RetryScheduler::RetryScheduler(const RetryPolicy& policy)
+  : mPolicy(policy),
+    mRandom(std::random_device()()),
+    mSequence(0),
+    mRunning(0),
+    mStopping(false) {
+  mDispatchThread = std::thread(&RetryScheduler::DispatchLoop, this);
+}
+
+RetryScheduler::~RetryScheduler() {
+  {
+    lock_guard<mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mScheduled.notify_one();
+  mDispatchThread.join();
+}
+
+milliseconds RetryScheduler::GetHoldOff(const string& endpoint) {
+  lock_guard<mutex> lock(mMutex);
+  auto it = mCircuits.find(endpoint);
+  if (it == mCircuits.end())
+    return milliseconds(0);
+
+  Circuit& circuit = it->second;
+  const auto now = Clock::now();
+  switch (circuit.state) {
+    case CircuitState::Open:
+      if (now < circuit.openUntil)
+        return std::chrono::duration_cast<milliseconds>(circuit.openUntil - now) + milliseconds(1);
+      // Cooled down, this caller is the probe
+      circuit.state = CircuitState::HalfOpen;
+      circuit.probeStarted = now;
+      return milliseconds(0);
+    case CircuitState::HalfOpen:
+      // A probe that never reported back must not keep the circuit shut for good
+      if (now - circuit.probeStarted >= mPolicy.breakerCooldown) {
+        circuit.probeStarted = now;
+        return milliseconds(0);
+      }
+      return mPolicy.baseDelay;
+    case CircuitState::Closed:
+    default:
+      return milliseconds(0);
+  }
+}
+
+milliseconds RetryScheduler::PeekHoldOff(const string& endpoint) const {
+  lock_guard<mutex> lock(mMutex);
+  auto it = mCircuits.find(endpoint);
+  if (it == mCircuits.end())
+    return milliseconds(0);
+
+  const Circuit& circuit = it->second;
+  const auto now = Clock::now();
+  switch (circuit.state) {
+    case CircuitState::Open:
+      if (now < circuit.openUntil)
+        return std::chrono::duration_cast<milliseconds>(circuit.openUntil - now) + milliseconds(1);
+      return milliseconds(0);
+    case CircuitState::HalfOpen:
+      return now - circuit.probeStarted >= mPolicy.breakerCooldown ? milliseconds(0) : mPolicy.baseDelay;
+    case CircuitState::Closed:
+    default:
+      return milliseconds(0);
+  }
+}
+
+void RetryScheduler::RecordSuccess(const string& endpoint) {
+  lock_guard<mutex> lock(mMutex);
+  auto it = mCircuits.find(endpoint);
+  if (it == mCircuits.end())
+    return;
+  it->second.state = CircuitState::Closed;
+  it->second.consecutiveFailures = 0;
+}
+
+void RetryScheduler::RecordFailure(const string& endpoint) {
+  lock_guard<mutex> lock(mMutex);
+  Circuit& circuit = mCircuits[endpoint];
+  circuit.consecutiveFailures++;
+  if (circuit.state == CircuitState::HalfOpen ||
+      (circuit.state == CircuitState::Closed && circuit.consecutiveFailures >= mPolicy.breakerThreshold))
+    Open(circuit, Clock::now());
+}
+
+void RetryScheduler::Open(Circuit& circuit, Clock::time_point now) {
+  circuit.state = CircuitState::Open;
+  circuit.openUntil = now + mPolicy.breakerCooldown;
+  mStats.breakerTrips++;
+}
+
+bool RetryScheduler::ScheduleRetry(int attempt, const Task& task) {
+  milliseconds delay;
+  {
+    lock_guard<mutex> lock(mMutex);
+    if (attempt >= mPolicy.maxAttempts) {
+      mStats.exhausted++;
+      return false;
+    }
+    mStats.retries++;
+
+    // Full jitter: uniform in [0, min(maxDelay, baseDelay * 2^(attempt - 1))]
+    milliseconds bound = mPolicy.baseDelay;
+    for (int i = 1; i < attempt && bound < mPolicy.maxDelay; i++)
+      bound *= 2;
+    if (bound > mPolicy.maxDelay)
+      bound = mPolicy.maxDelay;
+    std::uniform_int_distribution<milliseconds::rep> distribution(0, bound.count());
+    delay = milliseconds(distribution(mRandom));
+  }
+  Schedule(delay, task);
+  return true;
+}
+
+void RetryScheduler::ScheduleDeferred(milliseconds holdOff, const Task& task) {
+  {
+    lock_guard<mutex> lock(mMutex);
+    mStats.deferrals++;
+  }
+  Schedule(holdOff, task);
+}
+
+void RetryScheduler::Schedule(milliseconds delay, const Task& task) {
+  {
+    lock_guard<mutex> lock(mMutex);
+    mQueue.push(Scheduled{ Clock::now() + delay, mSequence++, task });
+  }
+  mScheduled.notify_one();
+}
+
+bool RetryScheduler::WaitIdle() {
+  unique_lock<mutex> lock(mMutex);
+  if (mQueue.empty() && mRunning == 0)
+    return false;
+  mIdle.wait(lock, [this] { return mQueue.empty() && mRunning == 0; });
+  return true;
+}
+
+RetryStats RetryScheduler::GetStats() const {
+  lock_guard<mutex> lock(mMutex);
+  RetryStats stats = mStats;
+  stats.pending = mQueue.size() + mRunning;
+  return stats;
+}
+
+void RetryScheduler::DispatchLoop() {
+  unique_lock<mutex> lock(mMutex);
+  while (!mStopping) {
+    if (mQueue.empty()) {
+      mScheduled.wait(lock);
+      continue;
+    }
+    const auto due = mQueue.top().due;
+    if (Clock::now() < due) {
+      mScheduled.wait_until(lock, due);
+      continue;
+    }
+
+    Task task = mQueue.top().task;
+    mQueue.pop();
+    mRunning++;
+    lock.unlock();
+    try {
+      task();
+    } catch (...) {
+      // Tasks only re-enqueue work, there is nobody to report a failure to
+    }
+    lock.lock();
+    mRunning--;
+    if (mQueue.empty() && mRunning == 0)
+      mIdle.notify_all();
+  }
+}
+
+} // namespace utils
+} // namespace sample
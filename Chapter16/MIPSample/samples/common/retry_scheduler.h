@@ -0,0 +1,155 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef SAMPLES_COMMON_RETRY_SCHEDULER_H_
+#define SAMPLES_COMMON_RETRY_SCHEDULER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sample {
+namespace utils {
+
+enum class FailureKind {
+  Transient, // mip::TransientNetworkError, mip::PolicySyncError: worth retrying, and a sign the endpoint struggles
+  EndpointDown, // mip::NetworkError: retrying will not help, but the endpoint is failing
+  Permanent, // Anything else, e.g. a bad file: says nothing about the endpoint
+};
+
+FailureKind ClassifyFailure(const std::exception& error);
+
+struct RetryPolicy {
+  int maxAttempts = 4; // Including the first one
+  std::chrono::milliseconds baseDelay = std::chrono::milliseconds(500);
+  std::chrono::milliseconds maxDelay = std::chrono::milliseconds(60000);
+  size_t breakerThreshold = 5; // Consecutive endpoint failures that open its circuit
+  std::chrono::milliseconds breakerCooldown = std::chrono::milliseconds(30000);
+};
+
+struct RetryStats {
+  uint64_t retries = 0; // Attempts scheduled after a transient failure
+  uint64_t deferrals = 0; // Attempts postponed because a circuit was open
+  uint64_t exhausted = 0; // Items that failed on their last attempt
+  uint64_t breakerTrips = 0; // Times a circuit opened
+  size_t pending = 0; // Scheduled and not yet started
+};
+
+// Retries work that failed for transient reasons without holding up the threads doing healthy work.
+//
+// Failed items are handed back through Schedule*, which runs them on the scheduler's thread once their delay has
+// passed; they should do no more than re-enqueue the item, e.g. submit it to a ThreadPool. Retry delays grow
+// exponentially from baseDelay and are drawn uniformly below that bound ("full jitter"), so a burst of failures does
+// not come back as a burst of retries.
+//
+// Each endpoint has a circuit breaker. After breakerThreshold consecutive failures its circuit opens and GetHoldOff
+// tells callers to stay away for breakerCooldown; then one probe is let through, and its outcome closes the circuit
+// or opens it again. Endpoints are whatever the caller uses to tell services apart, such as a host or an operation.
+class RetryScheduler final {
+public:
+  typedef std::function<void()> Task;
+
+  explicit RetryScheduler(const RetryPolicy& policy = RetryPolicy());
+  // Pending tasks are dropped, call WaitIdle first to run them
+  ~RetryScheduler();
+
+  RetryScheduler(const RetryScheduler&) = delete;
+  RetryScheduler& operator=(const RetryScheduler&) = delete;
+
+  const RetryPolicy& GetPolicy() const { return mPolicy; }
+
+  // Zero if endpoint may be called now, otherwise how long to postpone the call. Once an open circuit has cooled down
+  // the caller that gets zero is its probe, so only ask right before making the call.
+  std::chrono::milliseconds GetHoldOff(const std::string& endpoint);
+  // Same answer as GetHoldOff, but does not claim the probe. For checking an endpoint that will only be called later.
+  std::chrono::milliseconds PeekHoldOff(const std::string& endpoint) const;
+  void RecordSuccess(const std::string& endpoint);
+  void RecordFailure(const std::string& endpoint);
+
+  // attempt is the number of attempts made so far. Returns false, and counts the item as exhausted, if the policy
+  // allows no further attempt; the task is not scheduled then.
+  bool ScheduleRetry(int attempt, const Task& task);
+  // Postpones an attempt that was not made because of GetHoldOff
+  void ScheduleDeferred(std::chrono::milliseconds holdOff, const Task& task);
+
+  // Blocks until no task is pending. Returns whether there was anything to wait for.
+  bool WaitIdle();
+  RetryStats GetStats() const;
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  enum class CircuitState { Closed, Open, HalfOpen };
+
+  struct Circuit {
+    CircuitState state = CircuitState::Closed;
+    size_t consecutiveFailures = 0;
+    Clock::time_point openUntil;
+    Clock::time_point probeStarted; // HalfOpen only
+  };
+
+  struct Scheduled {
+    Clock::time_point due;
+    uint64_t sequence; // Keeps tasks due at the same time in order
+    Task task;
+
+    bool operator>(const Scheduled& other) const {
+      return due != other.due ? due > other.due : sequence > other.sequence;
+    }
+  };
+
+  void Schedule(std::chrono::milliseconds delay, const Task& task);
+  void Open(Circuit& circuit, Clock::time_point now);
+  void DispatchLoop();
+
+  RetryPolicy mPolicy;
+  mutable std::mutex mMutex;
+  std::condition_variable mScheduled;
+  std::condition_variable mIdle;
+  std::priority_queue<Scheduled, std::vector<Scheduled>, std::greater<Scheduled>> mQueue;
+  std::map<std::string, Circuit> mCircuits;
+  std::mt19937 mRandom;
+  uint64_t mSequence;
+  size_t mRunning; // Tasks taken off the queue and still running
+  bool mStopping;
+  RetryStats mStats;
+  std::thread mDispatchThread;
+};
+
+} // namespace utils
+} // namespace sample
+
+#endif // SAMPLES_COMMON_RETRY_SCHEDULER_H_
@@ -0,0 +1,309 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include "shared_token_cache.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::atomic;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+using std::lock_guard;
+using std::mutex;
+using std::runtime_error;
+using std::string;
+
+namespace sample {
+namespace auth {
+
+namespace {
+
+const uint64_t kMagic = 0x4d495053544b4331ULL; // "MIPSTKC1"
+const uint32_t kSlotCount = 64;
+const size_t kSlotDataSize = 8192 - 32; // Key followed by token
+const uint32_t kProbeLength = 4;
+const int kMaxReadAttempts = 64;
+const seconds kDefaultTokenLifetime(30 * 60); // Same assumption as TokenCache for tokens that are not JWTs
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+    "Atomics in shared memory must be lock-free to work across processes");
+
+uint64_t HashKey(const string& key) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : key) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+int64_t ToUnixSeconds(system_clock::time_point time) {
+  return std::chrono::duration_cast<seconds>(time.time_since_epoch()).count();
+}
+
+// Bytes of the lock file: byte i stands for fetching the keys whose probe starts at slot i, the byte after the
+// last slot for writing any slot. Length 0 locks the whole file, which initializing the segment does.
+const off_t kWriteLockOffset = kSlotCount;
+
+// Holds an exclusive fcntl lock on length bytes at offset of the file for the lifetime of the object
+class RangeLock final {
+public:
+  RangeLock(int file, off_t offset, off_t length) : mFile(file), mOffset(offset), mLength(length) {
+    while (SetLock(F_WRLCK) != 0) {
+      // The kernel detects deadlocks per process, so threads of two processes each waiting for a byte the other
+      // process holds look like one. Locks are only taken slot byte first, write byte second, so it cannot be real.
+      if (errno == EDEADLK)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      else if (errno != EINTR)
+        throw runtime_error("Failed to lock the shared token cache");
+    }
+  }
+  ~RangeLock() { SetLock(F_UNLCK); }
+
+private:
+  int SetLock(short type) {
+    struct flock range;
+    memset(&range, 0, sizeof(range));
+    range.l_type = type;
+    range.l_whence = SEEK_SET;
+    range.l_start = mOffset;
+    range.l_len = mLength;
+    return fcntl(mFile, type == F_UNLCK ? F_SETLK : F_SETLKW, &range);
+  }
+
+  int mFile;
+  off_t mOffset;
+  off_t mLength;
+};
+
+// Someone else's file, or one other users can open, could hand this process tokens or read the ones it shares
+void CheckPrivate(int file, const string& what) {
+  struct stat info;
+  if (fstat(file, &info) != 0)
+    throw runtime_error("Failed to check " + what);
+  if (info.st_uid != geteuid() || (info.st_mode & 077) != 0)
+    throw runtime_error(what + " must belong to the current user and be accessible by them only");
+}
+
+} // namespace
+
+struct SharedTokenCache::Slot {
+  atomic<uint32_t> sequence; // Odd while the slot is being written
+  uint32_t keyLength; // 0 for an empty slot
+  uint32_t tokenLength;
+  uint32_t reserved;
+  uint64_t keyHash;
+  int64_t expiresOn; // Unix seconds
+  char data[kSlotDataSize];
+};
+
+struct SharedTokenCache::Segment {
+  atomic<uint64_t> magic; // Set last, once the segment is initialized
+  uint32_t slotCount;
+  uint32_t slotSize;
+  Slot slots[kSlotCount];
+};
+
+SharedTokenCache::SharedTokenCache(const string& name, const string& lockFilePath, seconds minValidity)
+  : mSegment(nullptr),
+    mLockFile(-1),
+    mMinValidity(minValidity),
+    mFetchMutexes(new mutex[kSlotCount]),
+    mHitCount(0),
+    mFetchCount(0) {
+  if (name.size() < 2 || name[0] != '/' || name.find('/', 1) != string::npos)
+    throw std::invalid_argument("Shared token cache name must look like /name: " + name);
+
+  string lockPath = lockFilePath;
+  if (lockPath.empty()) {
+    // A directory only this user can write to, so nobody can put a file or link in place of the lock file
+    const char* runtimeDirectory = getenv("XDG_RUNTIME_DIR");
+    if (!runtimeDirectory || runtimeDirectory[0] != '/')
+      throw std::invalid_argument("XDG_RUNTIME_DIR is not set, a lock file path is needed for the shared token cache");
+    lockPath = string(runtimeDirectory) + "/" + name.substr(1) + ".lock";
+  }
+  mLockFile = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+  if (mLockFile < 0)
+    throw runtime_error("Failed to open shared token cache lock file: " + lockPath);
+
+  try {
+    CheckPrivate(mLockFile, "Shared token cache lock file " + lockPath);
+    RangeLock lock(mLockFile, 0, 0);
+    const int segmentFile = shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+    if (segmentFile < 0)
+      throw runtime_error("Failed to open shared memory segment: " + name);
+    try {
+      CheckPrivate(segmentFile, "Shared memory segment " + name);
+    } catch (...) {
+      close(segmentFile);
+      throw;
+    }
+
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if (fstat(segmentFile, &info) == 0 &&
+        (info.st_size >= static_cast<off_t>(sizeof(Segment)) || ftruncate(segmentFile, sizeof(Segment)) == 0)) {
+      mapping = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, segmentFile, 0);
+    }
+    close(segmentFile); // The mapping keeps the segment
+    if (mapping == MAP_FAILED)
+      throw runtime_error("Failed to map shared memory segment: " + name);
+    mSegment = static_cast<Segment*>(mapping);
+
+    // The first process initializes the segment. Holding the whole lock file, nobody is writing to it meanwhile.
+    if (mSegment->magic.load(std::memory_order_acquire) != kMagic ||
+        mSegment->slotCount != kSlotCount || mSegment->slotSize != sizeof(Slot)) {
+      mSegment->magic.store(0, std::memory_order_relaxed);
+      memset(static_cast<void*>(mSegment->slots), 0, sizeof(mSegment->slots));
+      mSegment->slotCount = kSlotCount;
+      mSegment->slotSize = sizeof(Slot);
+      mSegment->magic.store(kMagic, std::memory_order_release);
+    }
+  } catch (...) {
+    close(mLockFile);
+    throw;
+  }
+}
+
+SharedTokenCache::~SharedTokenCache() {
+  // The segment outlives the process on purpose, the next worker to start reuses its tokens
+  munmap(mSegment, sizeof(Segment));
+  close(mLockFile);
+}
+
+string SharedTokenCache::GetToken(
+    const string& identity,
+    const string& resource,
+    const string& authority,
+    const TokenCache::Fetcher& fetcher) {
+  const string key = identity + '\n' + resource + '\n' + authority;
+  const uint64_t keyHash = HashKey(key);
+
+  string token;
+  if (TryRead(key, keyHash, token)) {
+    mHitCount++;
+    return token;
+  }
+
+  // The key is only ever stored in the kProbeLength slots from its home slot on, so locking the home slot's byte
+  // is enough to fetch it once
+  const uint32_t homeSlot = keyHash % kSlotCount;
+  lock_guard<mutex> fetchLock(mFetchMutexes[homeSlot]);
+  RangeLock lock(mLockFile, homeSlot, 1);
+  // Whoever held the lock before may have fetched this very token
+  if (TryRead(key, keyHash, token)) {
+    mHitCount++;
+    return token;
+  }
+
+  token = fetcher(identity, resource, authority);
+  mFetchCount++;
+  system_clock::time_point expiresOn;
+  if (!GetJwtExpiry(token, expiresOn))
+    expiresOn = system_clock::now() + kDefaultTokenLifetime;
+  {
+    // Neighbouring home slots share slots, so writes are exclusive across all of them
+    lock_guard<mutex> writerLock(mWriterMutex);
+    RangeLock writeLock(mLockFile, kWriteLockOffset, 1);
+    Write(key, keyHash, token, ToUnixSeconds(expiresOn));
+  }
+  return token;
+}
+
+bool SharedTokenCache::TryRead(const string& key, uint64_t keyHash, string& token) const {
+  const int64_t validUntil = ToUnixSeconds(system_clock::now() + mMinValidity);
+  char buffer[kSlotDataSize];
+
+  for (uint32_t probe = 0; probe < kProbeLength; probe++) {
+    const Slot& slot = mSegment->slots[(keyHash + probe) % kSlotCount];
+    for (int attempt = 0; attempt < kMaxReadAttempts; attempt++) {
+      const uint32_t before = slot.sequence.load(std::memory_order_acquire);
+      if (before & 1)
+        continue; // A write is in progress
+      const uint32_t keyLength = slot.keyLength;
+      const uint32_t tokenLength = slot.tokenLength;
+      const uint64_t slotHash = slot.keyHash;
+      const int64_t expiresOn = slot.expiresOn;
+      const bool candidate = slotHash == keyHash && keyLength == key.size() &&
+          static_cast<size_t>(keyLength) + tokenLength <= kSlotDataSize;
+      if (candidate)
+        memcpy(buffer, slot.data, keyLength + tokenLength);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) != before)
+        continue; // Overwritten while being read, what was copied may be torn
+
+      if (candidate && expiresOn > validUntil && memcmp(buffer, key.data(), keyLength) == 0) {
+        token.assign(buffer + keyLength, tokenLength);
+        return true;
+      }
+      break;
+    }
+  }
+  return false;
+}
+
+void SharedTokenCache::Write(const string& key, uint64_t keyHash, const string& token, int64_t expiresOn) {
+  if (key.size() + token.size() > kSlotDataSize)
+    return;
+
+  // Reuse the key's slot, else an empty one, else the one expiring first
+  Slot* target = nullptr;
+  for (uint32_t probe = 0; probe < kProbeLength; probe++) {
+    Slot& slot = mSegment->slots[(keyHash + probe) % kSlotCount];
+    if (slot.keyHash == keyHash && slot.keyLength == key.size() && memcmp(slot.data, key.data(), key.size()) == 0) {
+      target = &slot;
+      break;
+    }
+    if (!target || (target->keyLength != 0 && (slot.keyLength == 0 || slot.expiresOn < target->expiresOn)))
+      target = &slot;
+  }
+
+  uint32_t sequence = target->sequence.load(std::memory_order_relaxed);
+  // Odd means a writer died mid-write. Under the write lock nobody else writes, so start over from an even number.
+  if (sequence & 1)
+    sequence++;
+  target->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  target->keyLength = static_cast<uint32_t>(key.size());
+  target->tokenLength = static_cast<uint32_t>(token.size());
+  target->keyHash = keyHash;
+  target->expiresOn = expiresOn;
+  memcpy(target->data, key.data(), key.size());
+  memcpy(target->data + key.size(), token.data(), token.size());
+  target->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+} // namespace auth
+} // namespace sample
@@ -0,0 +1,97 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef SAMPLES_COMMON_SHARED_TOKEN_CACHE_H_
+#define SAMPLES_COMMON_SHARED_TOKEN_CACHE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "token_cache.h"
+
+namespace sample {
+namespace auth {
+
+// Cache of OAuth2 access tokens shared by all processes on a machine through a POSIX shared-memory segment, so that
+// many worker processes acquire a token for an (identity, resource, authority) once instead of once each.
+//
+// - Readers never lock: every slot is a seqlock, and a reader that overlaps a write just reads again.
+// - On a miss the process locks the byte of the lock file that stands for the key's slot, checks again, and only
+//   then fetches. The processes that missed the same key wait on that byte and find the token cached once it is
+//   released; misses on keys of other slots fetch in parallel. Writing a slot takes a second, short lock.
+// - Tokens expiring within minValidity count as missing, so the TokenCache of each process refreshes from here
+//   without everyone fetching a new token.
+//
+// The segment and lock file are created readable by the current user only, and are refused if they belong to
+// anyone else or are open to other users. Tokens that do not fit in a slot are fetched without being shared.
+// POSIX only.
+class SharedTokenCache final {
+public:
+  // name is a shm_open name such as "/mip_sample_tokens"; the lock file defaults to $XDG_RUNTIME_DIR/<name>.lock
+  explicit SharedTokenCache(
+      const std::string& name,
+      const std::string& lockFilePath = "",
+      std::chrono::seconds minValidity = std::chrono::seconds(300));
+  ~SharedTokenCache();
+
+  SharedTokenCache(const SharedTokenCache&) = delete;
+  SharedTokenCache& operator=(const SharedTokenCache&) = delete;
+
+  std::string GetToken(
+      const std::string& identity,
+      const std::string& resource,
+      const std::string& authority,
+      const TokenCache::Fetcher& fetcher);
+
+  uint64_t GetHitCount() const { return mHitCount; }
+  uint64_t GetFetchCount() const { return mFetchCount; } // Tokens this process fetched for everyone
+
+private:
+  struct Segment;
+  struct Slot;
+
+  bool TryRead(const std::string& key, uint64_t keyHash, std::string& token) const;
+  void Write(const std::string& key, uint64_t keyHash, const std::string& token, int64_t expiresOn);
+
+  Segment* mSegment;
+  int mLockFile;
+  std::chrono::seconds mMinValidity;
+  // fcntl locks are held by the process, so threads of this process are kept apart by these
+  std::unique_ptr<std::mutex[]> mFetchMutexes; // One per slot
+  std::mutex mWriterMutex;
+  std::atomic<uint64_t> mHitCount;
+  std::atomic<uint64_t> mFetchCount;
+};
+
+} // namespace auth
+} // namespace sample
+
+#endif // SAMPLES_COMMON_SHARED_TOKEN_CACHE_H_
@@ -0,0 +1,110 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "thread_pool.h"
+
+#include <utility>
+
+using std::function;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+namespace sample {
+namespace utils {
+
+ThreadPool::ThreadPool(size_t workerCount, size_t maxQueuedTasks)
+    : mMaxQueuedTasks(maxQueuedTasks > 0 ? maxQueuedTasks : 1),
+      mActiveTasks(0),
+      mStopping(false) {
+  if (workerCount == 0)
+    workerCount = 1;
+
+  mWorkers.reserve(workerCount);
+  for (size_t i = 0; i < workerCount; i++)
+    mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mTaskAvailable.notify_all();
+  mSpaceAvailable.notify_all();
+
+  for (auto& worker : mWorkers)
+    worker.join();
+}
+
+void ThreadPool::Submit(const function<void()>& task) {
+  {
+    unique_lock<mutex> lock(mMutex);
+    mSpaceAvailable.wait(lock, [this] { return mTasks.size() < mMaxQueuedTasks || mStopping; });
+    if (mStopping)
+      return;
+    mTasks.push_back(task);
+  }
+  mTaskAvailable.notify_one();
+}
+
+void ThreadPool::Wait() {
+  unique_lock<mutex> lock(mMutex);
+  mIdle.wait(lock, [this] { return mTasks.empty() && mActiveTasks == 0; });
+}
+
+void ThreadPool::WorkerLoop() {
+  for (;;) {
+    function<void()> task;
+    {
+      unique_lock<mutex> lock(mMutex);
+      mTaskAvailable.wait(lock, [this] { return !mTasks.empty() || mStopping; });
+      // Drain whatever is still queued before honoring a stop request
+      if (mTasks.empty())
+        return;
+      task = std::move(mTasks.front());
+      mTasks.pop_front();
+      mActiveTasks++;
+    }
+    mSpaceAvailable.notify_one();
+
+    try {
+      task();
+    } catch (...) {
+    }
+
+    {
+      lock_guard<mutex> lock(mMutex);
+      mActiveTasks--;
+      if (mTasks.empty() && mActiveTasks == 0)
+        mIdle.notify_all();
+    }
+  }
+}
+
+} // namespace utils
+} // namespace sample
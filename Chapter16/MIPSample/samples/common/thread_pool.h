@@ -0,0 +1,80 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_THREAD_POOL_H_
+#define SAMPLES_COMMON_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sample {
+namespace utils {
+
+// Fixed-size pool of worker threads fed from a bounded queue. Submit() blocks
+// while the queue is full, which gives producers (e.g. a directory walk)
+// natural backpressure instead of buffering an unbounded amount of work.
+//
+// Tasks are expected to handle their own errors; an exception escaping a task
+// is swallowed so that a single bad item cannot terminate the process.
+class ThreadPool final {
+public:
+  ThreadPool(size_t workerCount, size_t maxQueuedTasks);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void Submit(const std::function<void()>& task);
+
+  // Blocks until the queue is empty and no task is running.
+  void Wait();
+
+  size_t GetWorkerCount() const { return mWorkers.size(); }
+
+private:
+  void WorkerLoop();
+
+  std::vector<std::thread> mWorkers;
+  std::deque<std::function<void()>> mTasks;
+  size_t mMaxQueuedTasks;
+  size_t mActiveTasks;
+  bool mStopping;
+  std::mutex mMutex;
+  std::condition_variable mTaskAvailable;
+  std::condition_variable mSpaceAvailable;
+  std::condition_variable mIdle;
+};
+
+} // namespace utils
+} // namespace sample
+
+#endif // SAMPLES_COMMON_THREAD_POOL_H_
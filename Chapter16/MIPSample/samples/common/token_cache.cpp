@@ -0,0 +1,237 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "token_cache.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <vector>
+
+using std::chrono::seconds;
+using std::chrono::system_clock;
+using std::current_exception;
+using std::lock_guard;
+using std::mutex;
+using std::promise;
+using std::shared_future;
+using std::string;
+using std::unique_lock;
+using std::vector;
+
+namespace {
+
+// Lifetime assumed for tokens whose expiry cannot be read. Kept short on purpose: refreshing early is cheap,
+// serving an expired token is not.
+static const seconds kDefaultTokenLifetime(30 * 60);
+// Delay before the background thread retries a refresh that failed.
+static const seconds kRefreshRetryDelay(30);
+// Tokens are no longer served this long before they expire, so that one handed out just before expiry (e.g. after
+// background refreshes failed) is not rejected by a server whose clock runs ahead or by the time it gets there.
+static const seconds kExpirySkew(60);
+
+bool DecodeBase64Url(const string& input, string& output) {
+  output.clear();
+  unsigned int buffer = 0;
+  int bits = 0;
+  for (char c : input) {
+    int value;
+    if (c >= 'A' && c <= 'Z') value = c - 'A';
+    else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+    else if (c >= '0' && c <= '9') value = c - '0' + 52;
+    else if (c == '-' || c == '+') value = 62;
+    else if (c == '_' || c == '/') value = 63;
+    else if (c == '=') break;
+    else return false;
+
+    buffer = (buffer << 6) | static_cast<unsigned int>(value);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      output.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+namespace sample {
+namespace auth {
+
+bool GetJwtExpiry(const string& token, system_clock::time_point& expiresOn) {
+  auto payloadStart = token.find('.');
+  if (payloadStart == string::npos)
+    return false;
+  auto payloadEnd = token.find('.', payloadStart + 1);
+  if (payloadEnd == string::npos)
+    return false;
+
+  string payload;
+  if (!DecodeBase64Url(token.substr(payloadStart + 1, payloadEnd - payloadStart - 1), payload))
+    return false;
+
+  static const string kExpClaim = "\"exp\"";
+  auto position = payload.find(kExpClaim);
+  if (position == string::npos)
+    return false;
+  position = payload.find(':', position + kExpClaim.size());
+  if (position == string::npos)
+    return false;
+  position++;
+  while (position < payload.size() && isspace(static_cast<unsigned char>(payload[position])))
+    position++;
+
+  const char* begin = payload.c_str() + position;
+  char* end = nullptr;
+  long long exp = strtoll(begin, &end, 10);
+  if (end == begin || exp <= 0)
+    return false;
+
+  expiresOn = system_clock::time_point(seconds(exp));
+  return true;
+}
+
+TokenCache::TokenCache(const Fetcher& fetcher, seconds refreshMargin)
+    : mFetcher(fetcher),
+      mRefreshMargin(refreshMargin),
+      mStopping(false) {
+  mRefreshThread = std::thread(&TokenCache::RefreshLoop, this);
+}
+
+TokenCache::~TokenCache() {
+  {
+    lock_guard<mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mRefreshWake.notify_all();
+  mRefreshThread.join();
+}
+
+string TokenCache::GetToken(const string& identity, const string& resource, const string& authority) {
+  const Key key(identity, resource, authority);
+  unique_lock<mutex> lock(mMutex);
+  Entry& entry = mEntries[key];
+
+  if (!entry.token.empty() && system_clock::now() + kExpirySkew < entry.expiresOn) {
+    entry.used = true;
+    return entry.token;
+  }
+
+  if (entry.pending.valid()) {
+    // Someone else is already fetching this token, share their result
+    shared_future<string> pending = entry.pending;
+    lock.unlock();
+    return pending.get();
+  }
+
+  return Fetch(key, entry, lock);
+}
+
+// Runs the fetcher for key with the lock released and publishes the result. Must be called with lock held and no
+// fetch pending for entry; std::map never moves its nodes, so entry stays valid while unlocked.
+string TokenCache::Fetch(const Key& key, Entry& entry, unique_lock<mutex>& lock) {
+  promise<string> fetched;
+  entry.pending = fetched.get_future().share();
+  lock.unlock();
+
+  string token;
+  try {
+    token = mFetcher(std::get<0>(key), std::get<1>(key), std::get<2>(key));
+  } catch (...) {
+    lock.lock();
+    entry.pending = shared_future<string>();
+    entry.refreshOn = system_clock::now() + kRefreshRetryDelay;
+    fetched.set_exception(current_exception());
+    throw;
+  }
+
+  const auto now = system_clock::now();
+  system_clock::time_point expiresOn;
+  if (!GetJwtExpiry(token, expiresOn))
+    expiresOn = now + kDefaultTokenLifetime;
+
+  // Short-lived tokens are refreshed halfway through their lifetime rather than immediately and repeatedly
+  auto refreshOn = expiresOn - mRefreshMargin;
+  if (refreshOn < now + kRefreshRetryDelay)
+    refreshOn = now + (expiresOn - now) / 2;
+  if (refreshOn < now + kRefreshRetryDelay)
+    refreshOn = now + kRefreshRetryDelay;
+
+  lock.lock();
+  entry.token = token;
+  entry.expiresOn = expiresOn;
+  entry.refreshOn = refreshOn;
+  entry.used = false;
+  entry.pending = shared_future<string>();
+  fetched.set_value(token);
+  mRefreshWake.notify_one();
+  return token;
+}
+
+void TokenCache::RefreshLoop() {
+  unique_lock<mutex> lock(mMutex);
+  while (!mStopping) {
+    const auto now = system_clock::now();
+    auto nextRefresh = system_clock::time_point::max();
+    vector<Key> due;
+
+    for (auto& item : mEntries) {
+      const Entry& entry = item.second;
+      // Tokens nobody asked for since the last fetch are left to expire
+      if (entry.token.empty() || entry.pending.valid() || !entry.used)
+        continue;
+      if (entry.refreshOn <= now)
+        due.push_back(item.first);
+      else if (entry.refreshOn < nextRefresh)
+        nextRefresh = entry.refreshOn;
+    }
+
+    for (const auto& key : due) {
+      if (mStopping)
+        break;
+      Entry& entry = mEntries[key];
+      if (entry.pending.valid())
+        continue;
+      try {
+        Fetch(key, entry, lock);
+      } catch (...) {
+        // The current token is still served until shortly before it expires; Fetch already scheduled a retry
+      }
+    }
+
+    if (!due.empty())
+      continue;
+
+    if (nextRefresh == system_clock::time_point::max())
+      mRefreshWake.wait(lock);
+    else
+      mRefreshWake.wait_until(lock, nextRefresh);
+  }
+}
+
+} // namespace auth
+} // namespace sample
@@ -0,0 +1,95 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLES_COMMON_TOKEN_CACHE_H_
+#define SAMPLES_COMMON_TOKEN_CACHE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+
+namespace sample {
+namespace auth {
+
+// Thread-safe cache of OAuth2 access tokens keyed by (identity, resource, authority).
+//
+// - Concurrent requests for a key that is not cached share a single call to the fetcher.
+// - The expiry of each token is read from its JWT 'exp' claim (or assumed if the token is opaque). A cached token is
+//   not served in the last minute before it expires, to allow for clock skew with the server.
+// - A background thread re-fetches tokens that are in use refreshMargin before they expire, so callers on the
+//   hot path normally find a valid token and never wait on the fetcher.
+class TokenCache final {
+public:
+  typedef std::function<std::string(
+      const std::string& identity,
+      const std::string& resource,
+      const std::string& authority)> Fetcher;
+
+  explicit TokenCache(const Fetcher& fetcher, std::chrono::seconds refreshMargin = std::chrono::seconds(300));
+  ~TokenCache();
+
+  TokenCache(const TokenCache&) = delete;
+  TokenCache& operator=(const TokenCache&) = delete;
+
+  std::string GetToken(const std::string& identity, const std::string& resource, const std::string& authority);
+
+private:
+  typedef std::tuple<std::string, std::string, std::string> Key;
+
+  struct Entry {
+    std::string token;
+    std::chrono::system_clock::time_point expiresOn;
+    std::chrono::system_clock::time_point refreshOn;
+    std::shared_future<std::string> pending; // Valid while a fetch for this key is in flight
+    bool used = false; // Served from the cache since it was last fetched
+  };
+
+  std::string Fetch(const Key& key, Entry& entry, std::unique_lock<std::mutex>& lock);
+  void RefreshLoop();
+
+  Fetcher mFetcher;
+  std::chrono::seconds mRefreshMargin;
+  std::map<Key, Entry> mEntries;
+  bool mStopping;
+  std::mutex mMutex;
+  std::condition_variable mRefreshWake;
+  std::thread mRefreshThread;
+};
+
+// Returns the expiry encoded in the 'exp' claim of a JWT, or false if token is not a JWT carrying one.
+bool GetJwtExpiry(const std::string& token, std::chrono::system_clock::time_point& expiresOn);
+
+} // namespace auth
+} // namespace sample
+
+#endif // SAMPLES_COMMON_TOKEN_CACHE_H_
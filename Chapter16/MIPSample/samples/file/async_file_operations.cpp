@@ -0,0 +1,104 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "async_file_operations.h"
+
+#include "mapped_file_stream.h"
+
+using mip::ContentState;
+using mip::FileEngine;
+using mip::FileHandler;
+using sample::utils::MappedFileStream;
+using std::exception_ptr;
+using std::make_shared;
+using std::shared_ptr;
+using std::static_pointer_cast;
+using std::string;
+
+namespace sample {
+namespace file {
+
+void ContinuationFileHandlerObserver::OnCreateFileHandlerSuccess(
+    const shared_ptr<FileHandler>& fileHandler,
+    const shared_ptr<void>& context) {
+  auto onComplete = static_pointer_cast<Completion<shared_ptr<FileHandler>>>(context);
+  (*onComplete)(fileHandler, nullptr);
+}
+
+void ContinuationFileHandlerObserver::OnCreateFileHandlerFailure(
+    const exception_ptr& error,
+    const shared_ptr<void>& context) {
+  auto onComplete = static_pointer_cast<Completion<shared_ptr<FileHandler>>>(context);
+  (*onComplete)(nullptr, error);
+}
+
+void ContinuationFileHandlerObserver::OnCommitSuccess(bool committed, const shared_ptr<void>& context) {
+  auto onComplete = static_pointer_cast<Completion<bool>>(context);
+  (*onComplete)(committed, nullptr);
+}
+
+void ContinuationFileHandlerObserver::OnCommitFailure(const exception_ptr& error, const shared_ptr<void>& context) {
+  auto onComplete = static_pointer_cast<Completion<bool>>(context);
+  (*onComplete)(false, error);
+}
+
+void CreateFileHandlerAsync(
+    const shared_ptr<FileEngine>& fileEngine,
+    const string& filePath,
+    ContentState contentState,
+    bool useMappedStream,
+    const Completion<shared_ptr<FileHandler>>& onComplete) {
+  auto context = make_shared<Completion<shared_ptr<FileHandler>>>(onComplete);
+  auto observer = make_shared<ContinuationFileHandlerObserver>();
+  // Errors raised before the SDK takes the request go to onComplete too, callers only ever look there
+  try {
+    // Here content identifier is same as the filePath
+    if (useMappedStream) {
+      auto inputStream = make_shared<MappedFileStream>(filePath);
+      fileEngine->CreateFileHandlerAsync(inputStream, filePath, filePath, contentState, false /*AuditDiscoveryEnabled*/, observer, context);
+    } else {
+      fileEngine->CreateFileHandlerAsync(filePath, filePath, contentState, false /*AuditDiscoveryEnabled*/, observer, context);
+    }
+  } catch (...) {
+    onComplete(nullptr, std::current_exception());
+  }
+}
+
+void CommitAsync(
+    const shared_ptr<FileHandler>& fileHandler,
+    const string& outputFilePath,
+    const Completion<bool>& onComplete) {
+  // The observer that receives commit results is the one the handler was created with
+  try {
+    fileHandler->CommitAsync(outputFilePath, make_shared<Completion<bool>>(onComplete));
+  } catch (...) {
+    onComplete(false, std::current_exception());
+  }
+}
+
+} // namespace file
+} // namespace sample
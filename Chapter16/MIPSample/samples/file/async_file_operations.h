@@ -0,0 +1,86 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLE_ASYNC_FILE_OPERATIONS_H_
+#define SAMPLE_ASYNC_FILE_OPERATIONS_H_
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "mip/file/file_engine.h"
+#include "mip/file/file_handler.h"
+
+namespace sample {
+namespace file {
+
+// Continuation invoked with either a result or an error. It runs on whichever thread the SDK completes the
+// operation on and must not throw.
+template <typename T>
+using Completion = std::function<void(const T& result, const std::exception_ptr& error)>;
+
+// FileHandler::Observer that resumes the Completion passed as context instead of fulfilling a promise, so no thread
+// has to wait on a future while the SDK works.
+class ContinuationFileHandlerObserver final : public mip::FileHandler::Observer {
+public:
+  void OnCreateFileHandlerSuccess(
+      const std::shared_ptr<mip::FileHandler>& fileHandler,
+      const std::shared_ptr<void>& context) override;
+
+  void OnCreateFileHandlerFailure(
+      const std::exception_ptr& error,
+      const std::shared_ptr<void>& context) override;
+
+  void OnCommitSuccess(
+      bool committed,
+      const std::shared_ptr<void>& context) override;
+
+  void OnCommitFailure(
+      const std::exception_ptr& error,
+      const std::shared_ptr<void>& context) override;
+};
+
+// Continuation-passing versions of FileEngine::CreateFileHandlerAsync and FileHandler::CommitAsync. The calling
+// thread returns immediately; onComplete is invoked once the SDK finishes. Commit results are delivered to the
+// observer the handler was created with, so CommitAsync only accepts handlers from CreateFileHandlerAsync below.
+void CreateFileHandlerAsync(
+    const std::shared_ptr<mip::FileEngine>& fileEngine,
+    const std::string& filePath,
+    mip::ContentState contentState,
+    bool useMappedStream,
+    const Completion<std::shared_ptr<mip::FileHandler>>& onComplete);
+
+void CommitAsync(
+    const std::shared_ptr<mip::FileHandler>& fileHandler,
+    const std::string& outputFilePath,
+    const Completion<bool>& onComplete);
+
+} // namespace file
+} // namespace sample
+
+#endif // SAMPLE_ASYNC_FILE_OPERATIONS_H_
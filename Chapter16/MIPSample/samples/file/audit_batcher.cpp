@@ -0,0 +1,185 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include "audit_batcher.h"
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using mip::FileEngine;
+using mip::FileHandler;
+using std::lock_guard;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::unique_lock;
+using std::vector;
+
+namespace sample {
+namespace file {
+
+AuditBatcher::AuditBatcher(
+    size_t batchSize,
+    std::chrono::milliseconds flushInterval,
+    size_t maxPending,
+    size_t maxHandlers)
+  : mBatchSize(batchSize > 0 ? batchSize : 1),
+    mFlushInterval(flushInterval),
+    mMaxPending(maxPending > mBatchSize ? maxPending : mBatchSize),
+    mMaxHandlers(maxHandlers > 0 ? maxHandlers : 1),
+    mEnqueuedCount(0),
+    mDoneCount(0),
+    mFlushTarget(0),
+    mHeldHandlers(0),
+    mStopping(false) {
+  mSubmitterThread = std::thread(&AuditBatcher::SubmitterLoop, this);
+}
+
+AuditBatcher::~AuditBatcher() {
+  {
+    lock_guard<mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mWorkAvailable.notify_one();
+  // The submitter drains the queue before it exits
+  mSubmitterThread.join();
+}
+
+void AuditBatcher::NotifyCommitSuccessful(const shared_ptr<FileHandler>& fileHandler, const string& contentIdentifier) {
+  if (!fileHandler)
+    throw std::invalid_argument("NotifyCommitSuccessful requires a file handler");
+  Event event;
+  event.fileHandler = fileHandler;
+  event.contentIdentifier = contentIdentifier;
+  Enqueue(std::move(event));
+}
+
+void AuditBatcher::SendApplicationAuditEvent(
+    const shared_ptr<FileEngine>& fileEngine,
+    const string& level,
+    const string& eventType,
+    const string& eventData) {
+  if (!fileEngine)
+    throw std::invalid_argument("SendApplicationAuditEvent requires a file engine");
+  Event event;
+  event.fileEngine = fileEngine;
+  event.level = level;
+  event.eventType = eventType;
+  event.eventData = eventData;
+  Enqueue(std::move(event));
+}
+
+void AuditBatcher::Enqueue(Event&& event) {
+  const bool holdsHandler = static_cast<bool>(event.fileHandler);
+  auto hasSpace = [this, holdsHandler] {
+    return mQueue.size() < mMaxPending && (!holdsHandler || mHeldHandlers < mMaxHandlers);
+  };
+  unique_lock<mutex> lock(mMutex);
+  if (!hasSpace()) {
+    mStats.producerWaits++;
+    mSpaceAvailable.wait(lock, hasSpace);
+  }
+  mQueue.push_back(std::move(event));
+  if (holdsHandler)
+    mHeldHandlers++;
+  mEnqueuedCount++;
+  mStats.queued++;
+  if (mQueue.size() > mStats.maxPendingSeen)
+    mStats.maxPendingSeen = mQueue.size();
+  if (mQueue.size() >= mBatchSize || mHeldHandlers >= mMaxHandlers)
+    mWorkAvailable.notify_one();
+}
+
+void AuditBatcher::Flush() {
+  unique_lock<mutex> lock(mMutex);
+  const uint64_t target = mEnqueuedCount;
+  if (target > mFlushTarget)
+    mFlushTarget = target;
+  mWorkAvailable.notify_one();
+  mSubmitted.wait(lock, [this, target] { return mDoneCount >= target; });
+}
+
+AuditBatcherStats AuditBatcher::GetStats() const {
+  lock_guard<mutex> lock(mMutex);
+  AuditBatcherStats stats = mStats;
+  stats.pending = mQueue.size();
+  return stats;
+}
+
+void AuditBatcher::SubmitterLoop() {
+  vector<Event> batch;
+  batch.reserve(mBatchSize);
+  unique_lock<mutex> lock(mMutex);
+  for (;;) {
+    mWorkAvailable.wait_for(lock, mFlushInterval, [this] {
+      return mStopping || mQueue.size() >= mBatchSize || mHeldHandlers >= mMaxHandlers || mFlushTarget > mDoneCount;
+    });
+    if (mQueue.empty()) {
+      if (mStopping)
+        return;
+      continue;
+    }
+
+    // A timed out wait submits whatever is queued, even less than a full batch
+    while (!mQueue.empty() && batch.size() < mBatchSize) {
+      batch.push_back(std::move(mQueue.front()));
+      mQueue.pop_front();
+    }
+    mSpaceAvailable.notify_all();
+    lock.unlock();
+
+    uint64_t failed = 0;
+    size_t handlers = 0;
+    for (auto& event : batch) {
+      if (event.fileHandler)
+        handlers++;
+      try {
+        if (event.fileHandler)
+          event.fileHandler->NotifyCommitSuccessful(event.contentIdentifier);
+        else
+          event.fileEngine->SendApplicationAuditEvent(event.level, event.eventType, event.eventData);
+      } catch (...) {
+        // Anything escaping here would end the submitter and leave Flush() waiting forever
+        failed++;
+      }
+    }
+    const size_t count = batch.size();
+    batch.clear(); // Release the handlers before taking the lock again
+
+    lock.lock();
+    mHeldHandlers -= handlers;
+    mSpaceAvailable.notify_all();
+    mDoneCount += count;
+    mStats.submitted += count - failed;
+    mStats.failed += failed;
+    mStats.batches++;
+    mSubmitted.notify_all();
+  }
+}
+
+} // namespace file
+} // namespace sample
@@ -0,0 +1,125 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef SAMPLE_AUDIT_BATCHER_H_
+#define SAMPLE_AUDIT_BATCHER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "mip/file/file_engine.h"
+#include "mip/file/file_handler.h"
+
+namespace sample {
+namespace file {
+
+struct AuditBatcherStats {
+  uint64_t queued = 0;
+  uint64_t submitted = 0;
+  uint64_t failed = 0; // The SDK call threw, the event is not retried
+  uint64_t batches = 0;
+  uint64_t producerWaits = 0; // Times a producer waited for maxPending events or maxHandlers handlers to drain
+  size_t pending = 0; // Queue depth right now
+  size_t maxPendingSeen = 0; // Highest queue depth so far
+};
+
+// Takes audit calls off the commit path. NotifyCommitSuccessful and SendApplicationAuditEvent only queue the event;
+// a background thread hands them to the SDK in batches once batchSize events are queued or flushInterval has passed,
+// whichever comes first. Flush() and the destructor return only after every event queued before them has been
+// submitted, so nothing is lost when a run ends. Producers only wait if maxPending events are already queued.
+//
+// A commit notification can only be sent through its FileHandler, which keeps the file open until then. At most
+// maxHandlers of them are held at once; reaching that cap submits the queue early and makes further commit
+// notifications wait, so a large run cannot run out of file descriptors behind the audit queue.
+//
+// The SDK has no bulk audit API, so each event is still its own SDK call; batching keeps those calls, and whatever
+// network traffic they cause, off the threads that label files.
+class AuditBatcher final {
+public:
+  AuditBatcher(
+      size_t batchSize = 64,
+      std::chrono::milliseconds flushInterval = std::chrono::milliseconds(1000),
+      size_t maxPending = 4096,
+      size_t maxHandlers = 32);
+  ~AuditBatcher();
+
+  AuditBatcher(const AuditBatcher&) = delete;
+  AuditBatcher& operator=(const AuditBatcher&) = delete;
+
+  // Keeps fileHandler alive until the notification has been submitted; waits while maxHandlers are held
+  void NotifyCommitSuccessful(const std::shared_ptr<mip::FileHandler>& fileHandler, const std::string& contentIdentifier);
+  void SendApplicationAuditEvent(
+      const std::shared_ptr<mip::FileEngine>& fileEngine,
+      const std::string& level,
+      const std::string& eventType,
+      const std::string& eventData);
+
+  void Flush();
+  AuditBatcherStats GetStats() const;
+
+private:
+  struct Event {
+    std::shared_ptr<mip::FileHandler> fileHandler; // Set for commit notifications
+    std::shared_ptr<mip::FileEngine> fileEngine; // Set for application events
+    std::string contentIdentifier; // Commit notifications only
+    std::string level; // Application events only, as are the two below
+    std::string eventType;
+    std::string eventData;
+  };
+
+  void Enqueue(Event&& event);
+  void SubmitterLoop();
+
+  const size_t mBatchSize;
+  const std::chrono::milliseconds mFlushInterval;
+  const size_t mMaxPending;
+  const size_t mMaxHandlers;
+
+  mutable std::mutex mMutex;
+  std::condition_variable mWorkAvailable;
+  std::condition_variable mSpaceAvailable;
+  std::condition_variable mSubmitted;
+  std::deque<Event> mQueue;
+  uint64_t mEnqueuedCount; // Sequence number of the last queued event
+  uint64_t mDoneCount; // Sequence number of the last event handed to the SDK, successfully or not
+  uint64_t mFlushTarget;
+  size_t mHeldHandlers; // Commit notifications queued or being submitted
+  bool mStopping;
+  AuditBatcherStats mStats;
+  std::thread mSubmitterThread;
+};
+
+} // namespace file
+} // namespace sample
+
+#endif // SAMPLE_AUDIT_BATCHER_H_
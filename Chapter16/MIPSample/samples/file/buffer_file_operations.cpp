@@ -0,0 +1,76 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include "buffer_file_operations.h"
+
+#include <future>
+#include <stdexcept>
+
+#include "file_handler_observer.h"
+#include "memory_stream.h"
+#include "mip/stream_utils.h"
+
+using mip::ContentState;
+using mip::FileEngine;
+using mip::FileHandler;
+using sample::utils::MemoryStream;
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace sample {
+namespace file {
+
+shared_ptr<FileHandler> CreateFileHandlerFromBuffer(
+    const shared_ptr<FileEngine>& fileEngine,
+    uint8_t* buffer,
+    int64_t size,
+    const string& fileName,
+    ContentState contentState) {
+  if (!buffer || size < 0)
+    throw std::invalid_argument("CreateFileHandlerFromBuffer requires a buffer");
+
+  auto inputStream = mip::CreateStreamFromBuffer(buffer, size);
+  auto createFileHandlerPromise = make_shared<std::promise<shared_ptr<FileHandler>>>();
+  auto createFileHandlerFuture = createFileHandlerPromise->get_future();
+  fileEngine->CreateFileHandlerAsync(inputStream, fileName, fileName, contentState, false /*AuditDiscoveryEnabled*/,
+      make_shared<FileHandlerObserver>(), createFileHandlerPromise);
+  return createFileHandlerFuture.get();
+}
+
+bool CommitToBuffer(const shared_ptr<FileHandler>& fileHandler, vector<uint8_t>& output, size_t expectedSize) {
+  auto outputStream = make_shared<MemoryStream>(expectedSize);
+  auto commitPromise = make_shared<std::promise<bool>>();
+  auto commitFuture = commitPromise->get_future();
+  fileHandler->CommitAsync(outputStream, commitPromise);
+  const bool committed = commitFuture.get();
+  output = committed ? outputStream->TakeBuffer() : vector<uint8_t>();
+  return committed;
+}
+
+} // namespace file
+} // namespace sample
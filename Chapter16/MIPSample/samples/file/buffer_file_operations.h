@@ -0,0 +1,64 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef SAMPLE_BUFFER_FILE_OPERATIONS_H_
+#define SAMPLE_BUFFER_FILE_OPERATIONS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mip/common_types.h"
+#include "mip/file/file_engine.h"
+#include "mip/file/file_handler.h"
+
+namespace sample {
+namespace file {
+
+// Creates a file handler over content the caller already holds in memory, without copying it. The SDK reads buffer
+// directly, so it must stay valid and unchanged until the handler and anything committed from it are released.
+// fileName is used as the content identifier and for its extension, which tells the SDK the file format.
+std::shared_ptr<mip::FileHandler> CreateFileHandlerFromBuffer(
+    const std::shared_ptr<mip::FileEngine>& fileEngine,
+    uint8_t* buffer,
+    int64_t size,
+    const std::string& fileName,
+    mip::ContentState contentState);
+
+// Commits the handler's pending changes to memory and moves the result into output, with no copy after the SDK has
+// written it. expectedSize sizes the output buffer up front; the input size is a good estimate. Returns false and
+// leaves output empty if there was nothing to commit.
+bool CommitToBuffer(
+    const std::shared_ptr<mip::FileHandler>& fileHandler,
+    std::vector<uint8_t>& output,
+    size_t expectedSize = 0);
+
+} // namespace file
+} // namespace sample
+
+#endif // SAMPLE_BUFFER_FILE_OPERATIONS_H_
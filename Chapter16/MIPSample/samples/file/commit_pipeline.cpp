@@ -0,0 +1,222 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include "commit_pipeline.h"
+
+#include <stdexcept>
+
+#include "async_file_operations.h"
+
+using mip::ContentState;
+using mip::FileEngine;
+using mip::FileHandler;
+using std::exception_ptr;
+using std::lock_guard;
+using std::make_shared;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::unique_lock;
+
+namespace sample {
+namespace file {
+
+void CommitPipeline::StageMeter::Enter(Clock::time_point now) {
+  if (active++ == 0)
+    busySince = now;
+  if (active > stats.maxActive)
+    stats.maxActive = active;
+}
+
+void CommitPipeline::StageMeter::Leave(Clock::time_point now, bool completed) {
+  if (--active == 0)
+    stats.busyMs += std::chrono::duration<double, std::milli>(now - busySince).count();
+  if (completed)
+    stats.completed++;
+}
+
+CommitPipeline::CommitPipeline(
+    const shared_ptr<FileEngine>& fileEngine,
+    ContentState contentState,
+    bool useMappedStream,
+    const ApplyStep& apply,
+    const CompletionStep& onComplete,
+    size_t stageCapacity)
+  : mFileEngine(fileEngine),
+    mContentState(contentState),
+    mUseMappedStream(useMappedStream),
+    mApply(apply),
+    mOnComplete(onComplete),
+    mStageCapacity(stageCapacity > 0 ? stageCapacity : 1),
+    mPending(0),
+    mStopping(false),
+    mStart(Clock::now()) {
+  if (!mFileEngine || !mApply || !mOnComplete)
+    throw std::invalid_argument("CommitPipeline requires an engine, an apply step and a completion step");
+  mApplyThread = std::thread(&CommitPipeline::ApplyLoop, this);
+}
+
+CommitPipeline::~CommitPipeline() {
+  Drain();
+  {
+    lock_guard<mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mStateChanged.notify_all();
+  mApplyThread.join();
+}
+
+void CommitPipeline::Submit(const string& filePath) {
+  auto item = make_shared<Item>();
+  item->filePath = filePath;
+  {
+    unique_lock<mutex> lock(mMutex);
+    // A file stays in the open stage until the pipeline thread takes it, which bounds the opened backlog too
+    mStateChanged.wait(lock, [this] { return mOpen.active < mStageCapacity; });
+    mOpen.Enter(Clock::now());
+    mPending++;
+  }
+
+  try {
+    CreateFileHandlerAsync(mFileEngine, filePath, mContentState, mUseMappedStream,
+        [this, item](const shared_ptr<FileHandler>& fileHandler, const exception_ptr& error) {
+      item->fileHandler = fileHandler;
+      OnOpened(item, error);
+    });
+  } catch (...) {
+    OnOpened(item, std::current_exception());
+  }
+}
+
+void CommitPipeline::OnOpened(const shared_ptr<Item>& item, const exception_ptr& error) {
+  if (error) {
+    {
+      lock_guard<mutex> lock(mMutex);
+      mOpen.Leave(Clock::now(), false);
+    }
+    Complete(item, false, error);
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(mMutex);
+    mOpened.push_back(item);
+  }
+  mStateChanged.notify_all();
+}
+
+void CommitPipeline::ApplyLoop() {
+  for (;;) {
+    shared_ptr<Item> item;
+    {
+      unique_lock<mutex> lock(mMutex);
+      mStateChanged.wait(lock, [this] { return mStopping || !mOpened.empty(); });
+      if (mOpened.empty())
+        return;
+      item = mOpened.front();
+      mOpened.pop_front();
+      const auto now = Clock::now();
+      mOpen.Leave(now, true);
+      mApplyMeter.Enter(now);
+    }
+    mStateChanged.notify_all();
+
+    exception_ptr error;
+    try {
+      mApply(*item);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    const bool commitNeeded = !error && !item->outputFilePath.empty();
+    {
+      unique_lock<mutex> lock(mMutex);
+      // The file is counted as applied, but holds its place until the commit stage has room for it
+      if (commitNeeded)
+        mStateChanged.wait(lock, [this] { return mCommit.active < mStageCapacity; });
+      const auto now = Clock::now();
+      mApplyMeter.Leave(now, !error);
+      if (commitNeeded)
+        mCommit.Enter(now);
+    }
+
+    if (!commitNeeded) {
+      Complete(item, false, error);
+      continue;
+    }
+
+    try {
+      CommitAsync(item->fileHandler, item->outputFilePath, [this, item](bool committed, const exception_ptr& error) {
+        OnCommitted(item, committed, error);
+      });
+    } catch (...) {
+      OnCommitted(item, false, std::current_exception());
+    }
+  }
+}
+
+void CommitPipeline::OnCommitted(const shared_ptr<Item>& item, bool committed, const exception_ptr& error) {
+  {
+    lock_guard<mutex> lock(mMutex);
+    mCommit.Leave(Clock::now(), !error);
+  }
+  mStateChanged.notify_all();
+  Complete(item, committed, error);
+}
+
+void CommitPipeline::Complete(const shared_ptr<Item>& item, bool committed, const exception_ptr& error) {
+  mOnComplete(*item, committed, error);
+  item->fileHandler.reset();
+  lock_guard<mutex> lock(mMutex);
+  mPending--;
+  // Notify under the lock: once the last file completes, Drain() may return and the pipeline be destroyed
+  mStateChanged.notify_all();
+}
+
+void CommitPipeline::Drain() {
+  unique_lock<mutex> lock(mMutex);
+  mStateChanged.wait(lock, [this] { return mPending == 0; });
+}
+
+CommitPipelineStats CommitPipeline::GetStats() const {
+  lock_guard<mutex> lock(mMutex);
+  const auto now = Clock::now();
+  CommitPipelineStats stats;
+  stats.wallMs = std::chrono::duration<double, std::milli>(now - mStart).count();
+  const StageMeter* meters[] = { &mOpen, &mApplyMeter, &mCommit };
+  PipelineStageStats* results[] = { &stats.open, &stats.apply, &stats.commit };
+  for (size_t i = 0; i < 3; i++) {
+    *results[i] = meters[i]->stats;
+    // Count the stretch a stage is busy right now
+    if (meters[i]->active > 0)
+      results[i]->busyMs += std::chrono::duration<double, std::milli>(now - meters[i]->busySince).count();
+    results[i]->utilization = stats.wallMs > 0 ? results[i]->busyMs / stats.wallMs : 0;
+  }
+  return stats;
+}
+
+} // namespace file
+} // namespace sample
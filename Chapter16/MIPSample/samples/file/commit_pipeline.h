@@ -0,0 +1,139 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef SAMPLE_COMMIT_PIPELINE_H_
+#define SAMPLE_COMMIT_PIPELINE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "mip/common_types.h"
+#include "mip/file/file_engine.h"
+#include "mip/file/file_handler.h"
+
+namespace sample {
+namespace file {
+
+struct PipelineStageStats {
+  size_t completed = 0;
+  size_t maxActive = 0; // Most files in the stage at once, including those waiting for the next stage
+  double busyMs = 0; // Time with at least one file in the stage
+  double utilization = 0; // busyMs over the pipeline's wall time
+};
+
+struct CommitPipelineStats {
+  PipelineStageStats open; // CreateFileHandlerAsync: reads and parses the input
+  PipelineStageStats apply; // The caller's ApplyStep: computes the label and protection changes
+  PipelineStageStats commit; // CommitAsync: writes the output
+  double wallMs = 0;
+};
+
+// Runs files through open -> apply -> commit so that consecutive files overlap: while file N+1 is being read, file N
+// has its changes applied and file N-1 is being written. Open and commit are driven by SDK callbacks, apply runs on
+// one pipeline thread. Each stage holds at most stageCapacity files; Submit() blocks once the open stage is full, and
+// files wait in a stage until the next one has room, so memory stays bounded however many files are submitted.
+class CommitPipeline final {
+public:
+  struct Item {
+    std::string filePath;
+    std::shared_ptr<mip::FileHandler> fileHandler;
+    // Set by the ApplyStep to commit the changes there, left empty when there is nothing to write
+    std::string outputFilePath;
+    // Free for the ApplyStep to pass state on to the CompletionStep
+    std::shared_ptr<void> context;
+  };
+
+  // Runs on the pipeline thread and may throw, the exception is passed on to the CompletionStep
+  typedef std::function<void(Item& item)> ApplyStep;
+  // Called exactly once per submitted file, on an SDK or pipeline thread. committed is false when nothing was written.
+  typedef std::function<void(Item& item, bool committed, const std::exception_ptr& error)> CompletionStep;
+
+  CommitPipeline(
+      const std::shared_ptr<mip::FileEngine>& fileEngine,
+      mip::ContentState contentState,
+      bool useMappedStream,
+      const ApplyStep& apply,
+      const CompletionStep& onComplete,
+      size_t stageCapacity);
+  // Waits for every submitted file
+  ~CommitPipeline();
+
+  CommitPipeline(const CommitPipeline&) = delete;
+  CommitPipeline& operator=(const CommitPipeline&) = delete;
+
+  void Submit(const std::string& filePath);
+  // Returns once every file submitted so far has completed
+  void Drain();
+  CommitPipelineStats GetStats() const;
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct StageMeter {
+    size_t active = 0;
+    Clock::time_point busySince;
+    PipelineStageStats stats;
+
+    void Enter(Clock::time_point now);
+    void Leave(Clock::time_point now, bool completed);
+  };
+
+  void OnOpened(const std::shared_ptr<Item>& item, const std::exception_ptr& error);
+  void OnCommitted(const std::shared_ptr<Item>& item, bool committed, const std::exception_ptr& error);
+  void Complete(const std::shared_ptr<Item>& item, bool committed, const std::exception_ptr& error);
+  void ApplyLoop();
+
+  std::shared_ptr<mip::FileEngine> mFileEngine;
+  mip::ContentState mContentState;
+  bool mUseMappedStream;
+  ApplyStep mApply;
+  CompletionStep mOnComplete;
+  size_t mStageCapacity;
+
+  mutable std::mutex mMutex;
+  std::condition_variable mStateChanged;
+  std::deque<std::shared_ptr<Item>> mOpened; // Opened, waiting for the pipeline thread
+  size_t mPending; // Submitted and not yet completed
+  bool mStopping;
+  Clock::time_point mStart;
+  StageMeter mOpen;
+  StageMeter mApplyMeter;
+  StageMeter mCommit;
+  std::thread mApplyThread;
+};
+
+} // namespace file
+} // namespace sample
+
+#endif // SAMPLE_COMMIT_PIPELINE_H_
@@ -0,0 +1,156 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "engine_pool.h"
+
+#include <stdexcept>
+
+using mip::FileEngine;
+using mip::FileProfile;
+using std::list;
+using std::lock_guard;
+using std::make_shared;
+using std::mutex;
+using std::promise;
+using std::shared_future;
+using std::shared_ptr;
+using std::string;
+using std::unique_lock;
+
+namespace sample {
+namespace file {
+
+EnginePool::EnginePool(
+    const shared_ptr<FileProfile>& fileProfile,
+    const SettingsFactory& settingsFactory,
+    size_t memoryBudget,
+    const CostEstimator& costEstimator)
+  : mFileProfile(fileProfile),
+    mSettingsFactory(settingsFactory),
+    mMemoryBudget(memoryBudget),
+    mCostEstimator(costEstimator) {
+  if (!mFileProfile)
+    throw std::invalid_argument("EnginePool requires a file profile");
+  if (!mCostEstimator)
+    mCostEstimator = [](const shared_ptr<FileEngine>&) { return kDefaultEngineCost; };
+}
+
+shared_ptr<FileEngine> EnginePool::Get(const string& identity) {
+  unique_lock<mutex> lock(mMutex);
+  auto found = mLookup.find(identity);
+  if (found != mLookup.end()) {
+    mEntries.splice(mEntries.begin(), mEntries, found->second);
+    mStats.hits++;
+    return found->second->engine;
+  }
+
+  auto pending = mPending.find(identity);
+  if (pending != mPending.end()) {
+    // Another request is already adding this engine, share its result
+    shared_future<shared_ptr<FileEngine>> creation = pending->second;
+    mStats.hits++;
+    lock.unlock();
+    return creation.get();
+  }
+
+  mStats.misses++;
+  promise<shared_ptr<FileEngine>> created;
+  mPending[identity] = created.get_future().share();
+  lock.unlock();
+
+  shared_ptr<FileEngine> engine;
+  size_t cost = 0;
+  try {
+    engine = AddEngine(identity);
+    cost = mCostEstimator(engine);
+  } catch (...) {
+    lock.lock();
+    mPending.erase(identity);
+    mStats.creationFailures++;
+    lock.unlock();
+    created.set_exception(std::current_exception());
+    throw;
+  }
+
+  lock.lock();
+  mPending.erase(identity);
+  Entry entry;
+  entry.identity = identity;
+  entry.engine = engine;
+  entry.cost = cost;
+  mEntries.push_front(entry);
+  mLookup[identity] = mEntries.begin();
+  mStats.memoryUsed += cost;
+  const list<string> evicted = Evict();
+  lock.unlock();
+
+  created.set_value(engine);
+  Unload(evicted);
+  return engine;
+}
+
+shared_ptr<FileEngine> EnginePool::AddEngine(const string& identity) {
+  const FileEngine::Settings settings = mSettingsFactory(identity);
+  auto addEnginePromise = make_shared<promise<shared_ptr<FileEngine>>>();
+  auto addEngineFuture = addEnginePromise->get_future();
+  mFileProfile->AddEngineAsync(settings, addEnginePromise);
+  return addEngineFuture.get();
+}
+
+list<string> EnginePool::Evict() {
+  list<string> engineIds;
+  auto it = mEntries.end();
+  while (mStats.memoryUsed > mMemoryBudget && it != mEntries.begin()) {
+    --it;
+    // The newest engine is about to be handed out, and engines held by callers are still in use
+    if (it == mEntries.begin() || it->engine.use_count() > 1)
+      continue;
+
+    engineIds.push_back(it->engine->GetSettings().GetEngineId());
+    mStats.memoryUsed -= it->cost;
+    mStats.evictions++;
+    mLookup.erase(it->identity);
+    it = mEntries.erase(it);
+  }
+  return engineIds;
+}
+
+void EnginePool::Unload(const list<string>& engineIds) {
+  // Unloading runs in the background, nobody needs to wait for it
+  for (const auto& engineId : engineIds)
+    mFileProfile->UnloadEngineAsync(engineId, make_shared<promise<void>>());
+}
+
+EnginePoolStats EnginePool::GetStats() const {
+  lock_guard<mutex> lock(mMutex);
+  EnginePoolStats stats = mStats;
+  stats.engineCount = mEntries.size();
+  return stats;
+}
+
+} // namespace file
+} // namespace sample
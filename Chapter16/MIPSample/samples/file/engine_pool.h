@@ -0,0 +1,110 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLE_ENGINE_POOL_H_
+#define SAMPLE_ENGINE_POOL_H_
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "mip/file/file_engine.h"
+#include "mip/file/file_profile.h"
+
+namespace sample {
+namespace file {
+
+struct EnginePoolStats {
+  size_t hits = 0; // Served from the pool, or from a creation already in flight
+  size_t misses = 0; // Needed a new engine
+  size_t evictions = 0;
+  size_t creationFailures = 0;
+  size_t engineCount = 0;
+  size_t memoryUsed = 0; // Sum of the estimated cost of the pooled engines
+};
+
+// Keeps FileEngines of many identities loaded in one FileProfile, so a service does not pay for AddEngineAsync on
+// every request.
+//
+// - Concurrent requests for an identity that is not pooled share a single AddEngineAsync.
+// - Engines are evicted least recently used first, with UnloadEngineAsync, once the estimated memory of the pooled
+//   engines exceeds memoryBudget. Engines still referenced outside the pool are never unloaded.
+// - The profile must have been loaded with ProfileObserver, which completes the unload requests.
+class EnginePool final {
+public:
+  typedef std::function<mip::FileEngine::Settings(const std::string& identity)> SettingsFactory;
+  // The SDK does not report engine memory, so the caller supplies an estimate, e.g. based on the policy size
+  typedef std::function<size_t(const std::shared_ptr<mip::FileEngine>& engine)> CostEstimator;
+
+  static const size_t kDefaultEngineCost = 4 * 1024 * 1024;
+
+  EnginePool(
+      const std::shared_ptr<mip::FileProfile>& fileProfile,
+      const SettingsFactory& settingsFactory,
+      size_t memoryBudget,
+      const CostEstimator& costEstimator = CostEstimator());
+
+  EnginePool(const EnginePool&) = delete;
+  EnginePool& operator=(const EnginePool&) = delete;
+
+  std::shared_ptr<mip::FileEngine> Get(const std::string& identity);
+
+  EnginePoolStats GetStats() const;
+
+private:
+  struct Entry {
+    std::string identity;
+    std::shared_ptr<mip::FileEngine> engine;
+    size_t cost;
+  };
+
+  std::shared_ptr<mip::FileEngine> AddEngine(const std::string& identity);
+  // Must be called with mMutex held. Returns the IDs of the engines to unload once the lock is released.
+  std::list<std::string> Evict();
+  void Unload(const std::list<std::string>& engineIds);
+
+  std::shared_ptr<mip::FileProfile> mFileProfile;
+  SettingsFactory mSettingsFactory;
+  size_t mMemoryBudget;
+  CostEstimator mCostEstimator;
+
+  mutable std::mutex mMutex;
+  std::list<Entry> mEntries; // Most recently used first
+  std::map<std::string, std::list<Entry>::iterator> mLookup;
+  std::map<std::string, std::shared_future<std::shared_ptr<mip::FileEngine>>> mPending;
+  EnginePoolStats mStats;
+};
+
+} // namespace file
+} // namespace sample
+
+#endif // SAMPLE_ENGINE_POOL_H_
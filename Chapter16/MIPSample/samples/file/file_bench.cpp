@@ -0,0 +1,707 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif // _WIN32
+
+#include "cxxopts.hpp"
+
+#include "auth_delegate_impl.h"
+#include "batch_policy_evaluator.h"
+#include "buffer_file_operations.h"
+#include "consent_delegate_impl.h"
+#include "engine_pool.h"
+#include "file_handler_observer.h"
+#include "latency_recorder.h"
+#include "mip/file/file_handler.h"
+#include "mip/file/file_profile.h"
+#include "mip/file/labeling_options.h"
+#include "mip/protection/protection_descriptor_builder.h"
+#include "mip/protection/protection_engine.h"
+#include "mip/protection/protection_handler.h"
+#include "mip/protection/protection_profile.h"
+#include "mip/upe/policy_engine.h"
+#include "mip/upe/policy_profile.h"
+#include "parallel_crypto_pipeline.h"
+#include "profile_observer.h"
+#include "protection_handler_cache.h"
+#include "replay_http_delegate.h"
+#include "string_utils.h"
+#include "thread_pool.h"
+
+using mip::AssignmentMethod;
+using mip::ContentState;
+using mip::FileEngine;
+using mip::FileHandler;
+using mip::FileProfile;
+using mip::Identity;
+using mip::LabelingOptions;
+using mip::PolicyEngine;
+using mip::PolicyProfile;
+using mip::ProtectionDescriptorBuilder;
+using mip::ProtectionEngine;
+using mip::ProtectionHandler;
+using mip::ProtectionHandlerCreationOptions;
+using mip::ProtectionProfile;
+using sample::auth::AuthDelegateImpl;
+using sample::consent::ConsentDelegateImpl;
+using sample::file::CommitToBuffer;
+using sample::file::CreateFileHandlerFromBuffer;
+using sample::file::EnginePool;
+using sample::http::ReplayHttpDelegate;
+using sample::upe::BatchPolicyEvaluator;
+using sample::upe::PolicyActionTable;
+using sample::upe::PolicyRecord;
+using sample::utils::LatencyRecorder;
+using sample::utils::ParallelCryptoPipeline;
+using sample::utils::ProtectionHandlerCache;
+using sample::utils::ThreadPool;
+using std::cout;
+using std::endl;
+using std::make_shared;
+using std::shared_ptr;
+using std::static_pointer_cast;
+using std::string;
+using std::vector;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double ElapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int GetIntOption(cxxopts::Options& options, const string& name, int defaultValue) {
+  if (!options.count(name))
+    return defaultValue;
+  int value = options[name].as<int>();
+  return value > 0 ? value : defaultValue;
+}
+
+vector<size_t> ParseSizes(const string& sizes) {
+  vector<size_t> result;
+  std::stringstream stream(sizes);
+  string item;
+  while (getline(stream, item, ',')) {
+    if (!item.empty())
+      result.push_back(static_cast<size_t>(std::stoull(item)));
+  }
+  return result;
+}
+
+string ReadFile(const string& path) {
+  std::ifstream ifs(FILENAME_STRING(path), std::ios::binary);
+  if (ifs.fail())
+    throw std::runtime_error("Failed to read path: " + path);
+  std::ostringstream content;
+  content << ifs.rdbuf();
+  return content.str();
+}
+
+void MakeDirectory(const string& path) {
+#ifdef _WIN32
+  CreateDirectoryW(ConvertStringToWString(path).c_str(), nullptr);
+#else
+  mkdir(path.c_str(), 0755);
+#endif // _WIN32
+}
+
+// Writes a single-page PDF whose content stream is padded to roughly size bytes. PDF is used because the SDK can
+// label it in place without protection, so the label stages need neither network nor auth.
+void WriteSyntheticPdf(const string& path, size_t size, size_t seed) {
+  std::ostringstream content;
+  content << "BT /F1 12 Tf 72 720 Td (Synthetic document " << seed << ") Tj ET\n";
+  const string line = "% Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor.\n";
+  while (static_cast<size_t>(content.tellp()) + line.size() < size)
+    content << line;
+  const string stream = content.str();
+
+  std::ostringstream pdf;
+  vector<std::streamoff> offsets;
+  pdf << "%PDF-1.4\n";
+  offsets.push_back(pdf.tellp());
+  pdf << "1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n";
+  offsets.push_back(pdf.tellp());
+  pdf << "2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n";
+  offsets.push_back(pdf.tellp());
+  pdf << "3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Contents 4 0 R "
+      "/Resources << /Font << /F1 5 0 R >> >> >>\nendobj\n";
+  offsets.push_back(pdf.tellp());
+  pdf << "4 0 obj\n<< /Length " << stream.size() << " >>\nstream\n" << stream << "\nendstream\nendobj\n";
+  offsets.push_back(pdf.tellp());
+  pdf << "5 0 obj\n<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>\nendobj\n";
+
+  const std::streamoff xref = pdf.tellp();
+  pdf << "xref\n0 " << offsets.size() + 1 << "\n0000000000 65535 f \n";
+  for (auto offset : offsets) {
+    char entry[21];
+    snprintf(entry, sizeof(entry), "%010lld 00000 n \n", static_cast<long long>(offset));
+    pdf << entry;
+  }
+  pdf << "trailer\n<< /Size " << offsets.size() + 1 << " /Root 1 0 R >>\nstartxref\n" << xref << "\n%%EOF\n";
+
+  std::ofstream out(FILENAME_STRING(path), std::ios::binary | std::ios::trunc);
+  if (out.fail())
+    throw std::runtime_error("Failed to write path: " + path);
+  out << pdf.str();
+}
+
+shared_ptr<FileProfile> LoadProfile(
+    const shared_ptr<mip::AuthDelegate>& authDelegate,
+    const shared_ptr<mip::HttpDelegate>& httpDelegate) {
+  FileProfile::Settings profileSettings(
+      "file_bench_storage",
+      true /*useInMemoryStorage*/,
+      authDelegate,
+      make_shared<ConsentDelegateImpl>(),
+      make_shared<ProfileObserver>(),
+      mip::ApplicationInfo{ "000", "FileBenchApp", "1.0.0.0" });
+  if (httpDelegate)
+    profileSettings.SetHttpDelegate(httpDelegate);
+
+  auto loadPromise = make_shared<std::promise<shared_ptr<FileProfile>>>();
+  auto loadFuture = loadPromise->get_future();
+  FileProfile::LoadAsync(profileSettings, loadPromise);
+  return loadFuture.get();
+}
+
+FileEngine::Settings CreateEngineSettings(const string& username, const string& policy, const string& protectionBaseUrl) {
+  FileEngine::Settings settings(Identity(username), "" /*clientData*/, "en-US");
+  settings.SetProtectionCloudEndpointBaseUrl(protectionBaseUrl);
+  settings.SetCustomSettings({ { mip::GetCustomSettingPolicyDataName(), policy } });
+  return settings;
+}
+
+shared_ptr<FileEngine> AddEngine(
+    const shared_ptr<FileProfile>& fileProfile,
+    const string& username,
+    const string& policy,
+    const string& protectionBaseUrl) {
+  const FileEngine::Settings settings = CreateEngineSettings(username, policy, protectionBaseUrl);
+  auto addEnginePromise = make_shared<std::promise<shared_ptr<FileEngine>>>();
+  auto addEngineFuture = addEnginePromise->get_future();
+  fileProfile->AddEngineAsync(settings, addEnginePromise);
+  return addEngineFuture.get();
+}
+
+shared_ptr<FileHandler> CreateFileHandler(const shared_ptr<FileEngine>& fileEngine, const string& filePath) {
+  auto createFileHandlerPromise = make_shared<std::promise<shared_ptr<FileHandler>>>();
+  auto createFileHandlerFuture = createFileHandlerPromise->get_future();
+  fileEngine->CreateFileHandlerAsync(filePath, filePath, ContentState::REST, false /*AuditDiscoveryEnabled*/,
+      make_shared<FileHandlerObserver>(), createFileHandlerPromise);
+  return createFileHandlerFuture.get();
+}
+
+bool Commit(const shared_ptr<FileHandler>& fileHandler, const string& outputFilePath) {
+  auto commitPromise = make_shared<std::promise<bool>>();
+  auto commitFuture = commitPromise->get_future();
+  fileHandler->CommitAsync(outputFilePath, commitPromise);
+  return commitFuture.get();
+}
+
+// Latencies of one stage plus its wall time, so both per-call percentiles and throughput can be reported
+struct Stage {
+  LatencyRecorder latency;
+  double wallMs = 0;
+  size_t failures = 0;
+};
+
+void Report(const string& name, const Stage& stage) {
+  const auto summary = stage.latency.GetSummary();
+  cout << "  " << name << ": " << summary;
+  if (stage.wallMs > 0)
+    cout << " files/sec=" << summary.count * 1000.0 / stage.wallMs;
+  if (stage.failures > 0)
+    cout << " failures=" << stage.failures;
+  cout << endl;
+}
+
+// Runs op once per file and records how long each call took
+template <typename Op>
+void RunStage(Stage& stage, const vector<string>& files, Op op) {
+  const auto stageStart = Clock::now();
+  for (const auto& file : files) {
+    const auto start = Clock::now();
+    try {
+      op(file);
+      stage.latency.Record(ElapsedMs(start));
+    } catch (const std::exception& ex) {
+      if (stage.failures++ == 0)
+        cout << "  First failure on " << file << ": " << ex.what() << endl;
+    }
+  }
+  stage.wallMs = ElapsedMs(stageStart);
+}
+
+// Opens a handler for every file first and then runs op on each of them, so that only op is timed; handler creation
+// is a stage of its own. Files whose handler cannot be created count as failures of the stage.
+template <typename Op>
+void RunHandlerStage(Stage& stage, const shared_ptr<FileEngine>& engine, const vector<string>& files, Op op) {
+  vector<string> openedFiles;
+  vector<shared_ptr<FileHandler>> handlers;
+  for (const auto& file : files) {
+    try {
+      handlers.push_back(CreateFileHandler(engine, file));
+      openedFiles.push_back(file);
+    } catch (const std::exception& ex) {
+      if (stage.failures++ == 0)
+        cout << "  First failure on " << file << ": " << ex.what() << endl;
+    }
+  }
+
+  size_t next = 0;
+  RunStage(stage, openedFiles, [&](const string& file) { op(handlers[next++], file); });
+}
+
+// Times one call of op over a payload of payloadSize bytes per iteration and reports MB/s alongside the latencies
+template <typename Op>
+void RunPayloadStage(const string& name, int64_t payloadSize, int iterations, Op op) {
+  Stage stage;
+  const auto stageStart = Clock::now();
+  for (int i = 0; i < iterations; i++) {
+    const auto start = Clock::now();
+    op();
+    stage.latency.Record(ElapsedMs(start));
+  }
+  stage.wallMs = ElapsedMs(stageStart);
+  cout << "  " << name << ": " << stage.latency.GetSummary() << " MB/s="
+      << payloadSize * iterations / 1048576.0 / (stage.wallMs / 1000.0) << endl;
+}
+
+// Compares single EncryptBuffer/DecryptBuffer calls over the whole payload with ParallelCryptoPipeline splitting it
+// across threadCount threads, and checks that both produce the same ciphertext and round-trip.
+void RunCryptoStages(
+    const shared_ptr<ProtectionHandler>& protectionHandler,
+    int64_t payloadSize,
+    size_t threadCount,
+    int iterations) {
+  vector<uint8_t> cleartext(static_cast<size_t>(payloadSize));
+  for (size_t i = 0; i < cleartext.size(); i++)
+    cleartext[i] = static_cast<uint8_t>(i * 31 + (i >> 12));
+
+  const int64_t encryptedSize = protectionHandler->GetProtectedContentLength(payloadSize, true);
+  vector<uint8_t> sequentialCiphertext(static_cast<size_t>(encryptedSize));
+  vector<uint8_t> decrypted(static_cast<size_t>(encryptedSize));
+  int64_t sequentialSize = 0;
+  RunPayloadStage("EncryptBuffer", payloadSize, iterations, [&]() {
+    sequentialSize = protectionHandler->EncryptBuffer(0, cleartext.data(), payloadSize, sequentialCiphertext.data(),
+        encryptedSize, true);
+  });
+  RunPayloadStage("DecryptBuffer", payloadSize, iterations, [&]() {
+    protectionHandler->DecryptBuffer(0, sequentialCiphertext.data(), sequentialSize, decrypted.data(),
+        static_cast<int64_t>(decrypted.size()), true);
+  });
+
+  ThreadPool pool(threadCount, threadCount * 2);
+  ParallelCryptoPipeline pipeline(protectionHandler, pool);
+  vector<uint8_t> ciphertext;
+  vector<uint8_t> roundTrip;
+  const string suffix = " (" + std::to_string(threadCount) + " threads)";
+  RunPayloadStage("parallel encrypt" + suffix, payloadSize, iterations, [&]() { ciphertext = pipeline.Encrypt(cleartext); });
+  RunPayloadStage("parallel decrypt" + suffix, payloadSize, iterations, [&]() { roundTrip = pipeline.Decrypt(ciphertext); });
+
+  sequentialCiphertext.resize(static_cast<size_t>(sequentialSize));
+  if (ciphertext != sequentialCiphertext || roundTrip != cleartext)
+    cout << "  ERROR: parallel output differs from EncryptBuffer/DecryptBuffer" << endl;
+}
+
+// Requests of a multi-tenant service going through an EnginePool that holds poolSize engines: a few identities are
+// hot and most are seen rarely, so the pool both hits and evicts.
+void RunEnginePoolStage(
+    const shared_ptr<FileProfile>& fileProfile,
+    const string& policy,
+    const string& protectionBaseUrl,
+    int identityCount,
+    int poolSize) {
+  EnginePool pool(fileProfile, [&](const string& identity) {
+    return CreateEngineSettings(identity, policy, protectionBaseUrl);
+  }, EnginePool::kDefaultEngineCost * static_cast<size_t>(poolSize));
+
+  vector<string> requests;
+  std::mt19937 random(42);
+  std::geometric_distribution<int> pick(0.2);
+  for (int i = 0; i < identityCount * 10; i++)
+    requests.push_back("tenant" + std::to_string(pick(random) % identityCount) + "@contoso.com");
+
+  Stage pooledGet;
+  RunStage(pooledGet, requests, [&](const string& identity) { pool.Get(identity); });
+  Report("pooled engine get", pooledGet);
+  const auto stats = pool.GetStats();
+  cout << "  hits=" << stats.hits << " misses=" << stats.misses << " evictions=" << stats.evictions
+      << " engines=" << stats.engineCount << endl;
+}
+
+// Consumes count documents that share one publishing license, once acquiring a use license per document and once
+// through a ProtectionHandlerCache, which should make a single round-trip for all of them.
+void RunLicenseStages(
+    const shared_ptr<mip::AuthDelegate>& authDelegate,
+    const shared_ptr<mip::HttpDelegate>& httpDelegate,
+    const string& username,
+    const string& protectionBaseUrl,
+    const vector<uint8_t>& publishingLicense,
+    int count) {
+  ProtectionProfile::Settings profileSettings("file_bench_storage", true /*useInMemoryStorage*/, authDelegate,
+      make_shared<ConsentDelegateImpl>(), mip::ApplicationInfo{ "000", "FileBenchApp", "1.0.0.0" });
+  if (httpDelegate)
+    profileSettings.SetHttpDelegate(httpDelegate);
+  auto protectionProfile = ProtectionProfile::Load(profileSettings);
+  ProtectionEngine::Settings engineSettings(Identity(username), "" /*clientData*/, "en-US");
+  engineSettings.SetCloudEndpointBaseUrl(protectionBaseUrl);
+  auto protectionEngine = protectionProfile->AddEngine(engineSettings);
+
+  vector<string> documents;
+  for (int i = 0; i < count; i++)
+    documents.push_back("document " + std::to_string(i));
+  Stage uncached;
+  RunStage(uncached, documents, [&](const string&) {
+    protectionEngine->CreateProtectionHandlerFromPublishingLicenseContext(
+        ProtectionProfile::GetPublishingLicenseContext(publishingLicense), ProtectionHandlerCreationOptions::None,
+        nullptr /*context*/);
+  });
+  Report("use license per document", uncached);
+
+  ProtectionHandlerCache cache(protectionEngine, 16);
+  Stage cached;
+  RunStage(cached, documents, [&](const string&) { cache.GetForPublishingLicense(publishingLicense); });
+  Report("use license from cache", cached);
+  cout << "  cache hits=" << cache.GetHitCount() << " misses=" << cache.GetMissCount() << endl;
+}
+
+// Settles the promise passed as context to PolicyProfile::LoadAsync and AddEngineAsync
+class PolicyProfileObserver final : public PolicyProfile::Observer {
+public:
+  void OnLoadSuccess(const shared_ptr<PolicyProfile>& profile, const shared_ptr<void>& context) override {
+    static_pointer_cast<std::promise<shared_ptr<PolicyProfile>>>(context)->set_value(profile);
+  }
+  void OnLoadFailure(const std::exception_ptr& error, const shared_ptr<void>& context) override {
+    static_pointer_cast<std::promise<shared_ptr<PolicyProfile>>>(context)->set_exception(error);
+  }
+  void OnAddEngineSuccess(const shared_ptr<PolicyEngine>& engine, const shared_ptr<void>& context) override {
+    static_pointer_cast<std::promise<shared_ptr<PolicyEngine>>>(context)->set_value(engine);
+  }
+  void OnAddEngineFailure(const std::exception_ptr& error, const shared_ptr<void>& context) override {
+    static_pointer_cast<std::promise<shared_ptr<PolicyEngine>>>(context)->set_exception(error);
+  }
+};
+
+// Metadata records as a content database would hold them: every other record already carries labelId, the others are
+// unlabeled and evaluated for the change to labelId. BatchPolicyEvaluator then computes their labels and actions
+// from the local policy, once on one worker and once on threadCount, without opening any file.
+void RunPolicyEvaluationStages(
+    const shared_ptr<mip::AuthDelegate>& authDelegate,
+    const shared_ptr<mip::HttpDelegate>& httpDelegate,
+    const string& username,
+    const string& policy,
+    const string& labelId,
+    int recordCount,
+    size_t threadCount,
+    int iterations) {
+  PolicyProfile::Settings profileSettings("file_bench_storage", true /*useInMemoryStorage*/, authDelegate,
+      make_shared<PolicyProfileObserver>(), mip::ApplicationInfo{ "000", "FileBenchApp", "1.0.0.0" });
+  if (httpDelegate)
+    profileSettings.SetHttpDelegate(httpDelegate);
+  auto loadPromise = make_shared<std::promise<shared_ptr<PolicyProfile>>>();
+  auto loadFuture = loadPromise->get_future();
+  PolicyProfile::LoadAsync(profileSettings, loadPromise);
+  auto policyProfile = loadFuture.get();
+
+  PolicyEngine::Settings engineSettings(Identity(username), "" /*clientData*/, "en-US");
+  engineSettings.SetCustomSettings({ { mip::GetCustomSettingPolicyDataName(), policy } });
+  auto addEnginePromise = make_shared<std::promise<shared_ptr<PolicyEngine>>>();
+  auto addEngineFuture = addEnginePromise->get_future();
+  policyProfile->AddEngineAsync(engineSettings, addEnginePromise);
+  auto policyEngine = addEngineFuture.get();
+
+  vector<PolicyRecord> records(static_cast<size_t>(recordCount));
+  const string labelPrefix = "MSIP_Label_" + labelId + "_";
+  for (size_t i = 0; i < records.size(); i++) {
+    PolicyRecord& record = records[i];
+    record.contentIdentifier = "record" + std::to_string(i);
+    if (i % 2 == 0) {
+      record.metadata.emplace_back(labelPrefix + "Enabled", "True");
+      record.metadata.emplace_back(labelPrefix + "Method", "Standard");
+    } else {
+      record.newLabelId = labelId;
+    }
+  }
+
+  PolicyActionTable sequentialTable;
+  PolicyActionTable parallelTable;
+  auto runEvaluateStage = [&](const string& name, size_t workerCount, PolicyActionTable& table) {
+    BatchPolicyEvaluator evaluator(policyEngine, workerCount);
+    Stage stage;
+    const auto stageStart = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+      const auto start = Clock::now();
+      table = evaluator.Evaluate(records);
+      stage.latency.Record(ElapsedMs(start));
+    }
+    stage.wallMs = ElapsedMs(stageStart);
+    cout << "  " << name << ": " << stage.latency.GetSummary() << " records/sec="
+        << records.size() * iterations * 1000.0 / stage.wallMs << " errors=" << table.errors.size() << endl;
+  };
+  runEvaluateStage("evaluate (1 worker)", 1, sequentialTable);
+  runEvaluateStage("evaluate (" + std::to_string(threadCount) + " workers)", threadCount, parallelTable);
+
+  // Dictionary indexes depend on which worker saw a label first, so compare the label IDs themselves
+  auto labelOf = [](const PolicyActionTable& table, size_t i) {
+    return table.labelIndex[i] == PolicyActionTable::kNoLabel ? string() : table.labelIds[table.labelIndex[i]];
+  };
+  for (size_t i = 0; i < records.size(); i++) {
+    if (labelOf(sequentialTable, i) != labelOf(parallelTable, i) ||
+        sequentialTable.actionMask[i] != parallelTable.actionMask[i]) {
+      cout << "  ERROR: parallel evaluation differs from a single worker at record " << i << endl;
+      break;
+    }
+  }
+}
+
+} // namespace
+
+// Times the stages of the file sample separately over synthetic corpora, using a local policy so the label and
+// policy evaluation stages run offline. Protect and unprotect need the protection service (or a --replayhttp
+// recording) and a template ID; the crypto and license stages then reuse the content key and publishing license of
+// the first protected file.
+int main(int argc, char** argv) {
+  try {
+    cxxopts::Options options("file_bench", "Benchmark for the File SDK operations used by file_sample");
+    options.add_options()
+      ("policy", "Path to the local policy file (Default=policy.xml)", cxxopts::value<string>())
+      ("corpus", "Directory the synthetic files are written to (Default=file_bench_corpus)", cxxopts::value<string>())
+      ("sizes", "Comma-separated file sizes in bytes, one corpus per size (Default=4096,262144,4194304)", cxxopts::value<string>())
+      ("count", "Number of files per corpus (Default=100)", cxxopts::value<int>())
+      ("iterations", "Number of profile loads and engine adds to time (Default=5)", cxxopts::value<int>())
+      ("labelid", "Label applied by the SetLabel stage (Default=General from the sample policy)", cxxopts::value<string>())
+      ("templateid", "Template used by the protect and unprotect stages, which are skipped without it", cxxopts::value<string>())
+      ("identities", "Identities the engine pool stage spreads its requests over (Default=50)", cxxopts::value<int>())
+      ("poolsize", "Engines the engine pool stage keeps loaded (Default=8)", cxxopts::value<int>())
+      ("username", "Identity of the engine (Default=stub_user@contoso.com)", cxxopts::value<string>())
+      ("password", "Set password for authentication.", cxxopts::value<string>())
+      ("clientid", "Set ClientID for authentication.", cxxopts::value<string>())
+      ("protectiontoken", "Set authentication token for protection.", cxxopts::value<string>())
+      ("protectionbaseurl", "Cloud endpoint base url for protection operations", cxxopts::value<string>())
+      ("cryptosize", "Payload in bytes for the EncryptBuffer/DecryptBuffer stages, which need --templateid (Default=67108864)", cxxopts::value<int>())
+      ("cryptothreads", "Threads used by the parallel encrypt and decrypt stages (Default=number of cores)", cxxopts::value<int>())
+      ("records", "Metadata records evaluated by the policy evaluation stages (Default=100000)", cxxopts::value<int>())
+      ("evalthreads", "Workers of the parallel policy evaluation stage (Default=number of cores)", cxxopts::value<int>())
+      ("replayhttp", "Answer SDK HTTP requests from a file_sample --recordhttp recording", cxxopts::value<string>())
+      ("h,help", "Print help and exit.");
+    options.parse(argc, argv);
+
+    if (options.count("help")) {
+      cout << options.help({ "" }) << endl;
+      return 0;
+    }
+
+    const string policyPath = options.count("policy") ? options["policy"].as<string>() : "policy.xml";
+    const string corpus = options.count("corpus") ? options["corpus"].as<string>() : "file_bench_corpus";
+    const vector<size_t> sizes = ParseSizes(options.count("sizes") ? options["sizes"].as<string>() : "4096,262144,4194304");
+    const int count = GetIntOption(options, "count", 100);
+    const int iterations = GetIntOption(options, "iterations", 5);
+    const string labelId = options.count("labelid") ?
+        options["labelid"].as<string>() : "d77edb09-ae2f-48b0-a7cb-77e50345830b";
+    const string templateId = options.count("templateid") ? options["templateid"].as<string>() : string();
+    const string username = options.count("username") ? options["username"].as<string>() : "stub_user@contoso.com";
+    const string protectionBaseUrl = options["protectionbaseurl"].as<string>();
+    const int64_t cryptoSize = GetIntOption(options, "cryptosize", 64 * 1024 * 1024);
+    const int cryptoThreads = GetIntOption(options, "cryptothreads",
+        std::thread::hardware_concurrency() > 0 ? static_cast<int>(std::thread::hardware_concurrency()) : 1);
+
+    const string policy = ReadFile(policyPath);
+    auto authDelegate = make_shared<AuthDelegateImpl>(options["password"].as<string>(), options["clientid"].as<string>(),
+        "" /*sccToken*/, options["protectiontoken"].as<string>());
+    shared_ptr<mip::HttpDelegate> httpDelegate;
+    if (options.count("replayhttp"))
+      httpDelegate = make_shared<ReplayHttpDelegate>(options["replayhttp"].as<string>());
+
+    cout << "Startup (" << iterations << " iterations)" << endl;
+    Stage profileLoad;
+    Stage engineAdd;
+    shared_ptr<FileProfile> profile;
+    shared_ptr<FileEngine> engine;
+    for (int i = 0; i < iterations; i++) {
+      // Release the previous profile first so every iteration is a cold load
+      engine.reset();
+      profile.reset();
+      auto start = Clock::now();
+      profile = LoadProfile(authDelegate, httpDelegate);
+      profileLoad.latency.Record(ElapsedMs(start));
+
+      start = Clock::now();
+      engine = AddEngine(profile, username, policy, protectionBaseUrl);
+      engineAdd.latency.Record(ElapsedMs(start));
+    }
+    Report("profile load", profileLoad);
+    Report("engine add", engineAdd);
+
+    const int identityCount = GetIntOption(options, "identities", 50);
+    const int poolSize = GetIntOption(options, "poolsize", 8);
+    cout << "Engine pool (" << identityCount << " identities, " << poolSize << " engines)" << endl;
+    RunEnginePoolStage(profile, policy, protectionBaseUrl, identityCount, poolSize);
+
+    const int recordCount = GetIntOption(options, "records", 100000);
+    const int evalThreads = GetIntOption(options, "evalthreads",
+        std::thread::hardware_concurrency() > 0 ? static_cast<int>(std::thread::hardware_concurrency()) : 1);
+    cout << "Policy evaluation: " << recordCount << " metadata records" << endl;
+    try {
+      RunPolicyEvaluationStages(authDelegate, httpDelegate, username, policy, labelId, recordCount,
+          static_cast<size_t>(evalThreads), iterations);
+    } catch (const std::exception& ex) {
+      cout << "  policy evaluation stages failed: " << ex.what() << endl;
+    }
+
+    MakeDirectory(corpus);
+    // Protection of the first protected file, reused by the crypto and license stages
+    shared_ptr<ProtectionHandler> sampleProtection;
+    LabelingOptions labelingOptions(AssignmentMethod::PRIVILEGED, mip::ActionSource::MANUAL);
+
+    for (size_t size : sizes) {
+      const string directory = corpus + "/" + std::to_string(size);
+      MakeDirectory(directory);
+      vector<string> files;
+      for (int i = 0; i < count; i++) {
+        files.push_back(directory + "/doc" + std::to_string(i) + ".pdf");
+        WriteSyntheticPdf(files.back(), size, static_cast<size_t>(i));
+      }
+
+      cout << "Corpus: " << count << " files of " << size << " bytes" << endl;
+
+      Stage handlerCreation;
+      RunStage(handlerCreation, files, [&](const string& file) { CreateFileHandler(engine, file); });
+      Report("handler creation", handlerCreation);
+
+      Stage getLabel;
+      RunHandlerStage(getLabel, engine, files, [&](const shared_ptr<FileHandler>& fileHandler, const string&) {
+        fileHandler->GetLabel();
+        fileHandler->GetProtection();
+      });
+      Report("GetLabel", getLabel);
+
+      Stage setLabel;
+      RunHandlerStage(setLabel, engine, files, [&](const shared_ptr<FileHandler>& fileHandler, const string& file) {
+        fileHandler->SetLabel(labelId, labelingOptions);
+        const string output = file + ".labeled.pdf";
+        Commit(fileHandler, output);
+        remove(output.c_str());
+      });
+      Report("SetLabel+Commit", setLabel);
+
+      // Same work on content that is already in memory, as an upload would be: the output goes to a buffer instead of a
+      // file. As above, the handlers are created before the timing starts.
+      Stage setLabelInMemory;
+      {
+        vector<string> contents;
+        contents.reserve(files.size()); // The handlers point into the strings
+        vector<shared_ptr<FileHandler>> handlers;
+        for (const auto& file : files) {
+          contents.push_back(ReadFile(file));
+          string& content = contents.back();
+          handlers.push_back(CreateFileHandlerFromBuffer(engine, reinterpret_cast<uint8_t*>(&content[0]),
+              static_cast<int64_t>(content.size()), file, ContentState::REST));
+        }
+        size_t next = 0;
+        RunStage(setLabelInMemory, files, [&](const string&) {
+          const size_t index = next++;
+          handlers[index]->SetLabel(labelId, labelingOptions);
+          vector<uint8_t> output;
+          CommitToBuffer(handlers[index], output, contents[index].size());
+        });
+      }
+      Report("SetLabel+Commit in memory", setLabelInMemory);
+
+      if (templateId.empty()) {
+        cout << "  protect, unprotect: skipped, no --templateid" << endl;
+        continue;
+      }
+
+      vector<string> protectedFiles;
+      Stage protect;
+      RunHandlerStage(protect, engine, files, [&](const shared_ptr<FileHandler>& fileHandler, const string& file) {
+        fileHandler->SetProtection(ProtectionDescriptorBuilder::CreateFromTemplate(templateId)->Build());
+        const string output = file + ".protected.pdf";
+        if (Commit(fileHandler, output))
+          protectedFiles.push_back(output);
+      });
+      Report("protect", protect);
+      if (!sampleProtection && !protectedFiles.empty())
+        sampleProtection = CreateFileHandler(engine, protectedFiles.front())->GetProtection();
+
+      Stage unprotect;
+      RunHandlerStage(unprotect, engine, protectedFiles, [&](const shared_ptr<FileHandler>& fileHandler, const string& file) {
+        fileHandler->RemoveProtection();
+        const string output = file + ".unprotected.pdf";
+        Commit(fileHandler, output);
+        remove(output.c_str());
+      });
+      Report("unprotect", unprotect);
+
+      for (const auto& file : protectedFiles)
+        remove(file.c_str());
+    }
+
+    if (sampleProtection) {
+      cout << "Crypto: " << cryptoSize << " bytes" << endl;
+      try {
+        RunCryptoStages(sampleProtection, cryptoSize, static_cast<size_t>(cryptoThreads), iterations);
+      } catch (const std::exception& ex) {
+        cout << "  crypto stages failed: " << ex.what() << endl;
+      }
+
+      cout << "Use licenses: " << count << " documents sharing one publishing license" << endl;
+      try {
+        RunLicenseStages(authDelegate, httpDelegate, username, protectionBaseUrl,
+            sampleProtection->GetSerializedPublishingLicense(), count);
+      } catch (const std::exception& ex) {
+        cout << "  license stages failed: " << ex.what() << endl;
+      }
+    }
+  } catch (const cxxopts::OptionException& ex) {
+    cout << "Error parsing options: " << ex.what() << endl;
+    return -1;
+  } catch (const std::exception& ex) {
+    cout << "Something bad happend: " << ex.what() << "\nExiting." << endl;
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,241 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "file_enumerator.h"
+
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "string_utils.h"
+
+using std::condition_variable;
+using std::exception_ptr;
+using std::function;
+using std::ifstream;
+using std::mutex;
+using std::runtime_error;
+using std::string;
+using std::thread;
+using std::unique_lock;
+using std::vector;
+
+namespace {
+
+static const char kPathSeparator = '/';
+
+string JoinPath(const string& directory, const string& name) {
+  if (directory.empty())
+    return name;
+  char last = directory[directory.size() - 1];
+  if (last == '/' || last == '\\')
+    return directory + name;
+  return directory + kPathSeparator + name;
+}
+
+// Lists the direct children of directory, splitting them into files and subdirectories.
+#ifdef _WIN32
+void ListDirectory(const string& directory, vector<string>& files, vector<string>& subdirectories) {
+  WIN32_FIND_DATAW findData;
+  HANDLE find = FindFirstFileW(ConvertStringToWString(JoinPath(directory, "*")).c_str(), &findData);
+  if (find == INVALID_HANDLE_VALUE)
+    throw runtime_error("Failed to open directory: " + directory);
+
+  do {
+    string name = ConvertWStringToString(findData.cFileName);
+    if (name == "." || name == "..")
+      continue;
+    if (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+      continue;
+    if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+      subdirectories.push_back(JoinPath(directory, name));
+    else
+      files.push_back(JoinPath(directory, name));
+  } while (FindNextFileW(find, &findData));
+
+  FindClose(find);
+}
+#else
+void ListDirectory(const string& directory, vector<string>& files, vector<string>& subdirectories) {
+  DIR* dir = opendir(directory.c_str());
+  if (dir == nullptr)
+    throw runtime_error("Failed to open directory: " + directory);
+
+  while (struct dirent* entry = readdir(dir)) {
+    string name = entry->d_name;
+    if (name == "." || name == "..")
+      continue;
+
+    string path = JoinPath(directory, name);
+    unsigned char type = entry->d_type;
+    if (type == DT_UNKNOWN) {
+      // Not every file system fills in d_type
+      struct stat info;
+      if (lstat(path.c_str(), &info) != 0)
+        continue;
+      type = S_ISDIR(info.st_mode) ? DT_DIR : S_ISREG(info.st_mode) ? DT_REG : DT_LNK;
+    }
+
+    if (type == DT_DIR)
+      subdirectories.push_back(path);
+    else if (type == DT_REG)
+      files.push_back(path);
+  }
+
+  closedir(dir);
+}
+#endif // _WIN32
+
+} // namespace
+
+namespace sample {
+namespace file {
+
+void EnumerateDirectory(
+    const string& directory,
+    const function<void(const string&)>& onFile,
+    const DirectoryErrorCallback& onDirectoryError) {
+  vector<string> pending(1, directory);
+  bool isRoot = true;
+  while (!pending.empty()) {
+    string current = pending.back();
+    pending.pop_back();
+
+    vector<string> files;
+    vector<string> subdirectories;
+    try {
+      ListDirectory(current, files, subdirectories);
+    } catch (const std::exception& ex) {
+      if (isRoot || !onDirectoryError)
+        throw;
+      onDirectoryError(current, ex.what());
+      continue;
+    }
+    isRoot = false;
+
+    for (const auto& file : files)
+      onFile(file);
+    pending.insert(pending.end(), subdirectories.rbegin(), subdirectories.rend());
+  }
+}
+
+void EnumerateDirectoryParallel(
+    const string& directory,
+    size_t threadCount,
+    const function<void(const string&)>& onFile,
+    const DirectoryErrorCallback& onDirectoryError) {
+  if (threadCount <= 1) {
+    EnumerateDirectory(directory, onFile, onDirectoryError);
+    return;
+  }
+
+  // Only directories are queued, so the queue stays small even for very large trees
+  mutex stateMutex;
+  condition_variable stateChanged;
+  vector<string> pending(1, directory);
+  size_t listing = 0; // Directories being listed right now, which may still add to pending
+  exception_ptr error;
+
+  auto worker = [&]() {
+    unique_lock<mutex> lock(stateMutex);
+    for (;;) {
+      stateChanged.wait(lock, [&] { return !pending.empty() || listing == 0 || error; });
+      if (error || pending.empty())
+        break; // Failed, or nothing left and nobody can add more
+
+      string current = pending.back();
+      pending.pop_back();
+      listing++;
+      lock.unlock();
+
+      vector<string> files;
+      vector<string> subdirectories;
+      exception_ptr listError;
+      try {
+        bool listed = false;
+        try {
+          ListDirectory(current, files, subdirectories);
+          listed = true;
+        } catch (const std::exception& ex) {
+          if (current == directory || !onDirectoryError)
+            throw;
+          onDirectoryError(current, ex.what());
+        }
+        if (listed) {
+          for (const auto& file : files)
+            onFile(file);
+        }
+      } catch (...) {
+        listError = std::current_exception();
+      }
+
+      lock.lock();
+      listing--;
+      if (listError && !error)
+        error = listError;
+      pending.insert(pending.end(), subdirectories.rbegin(), subdirectories.rend());
+      stateChanged.notify_all();
+    }
+  };
+
+  vector<thread> threads;
+  for (size_t i = 0; i < threadCount; i++)
+    threads.emplace_back(worker);
+  for (auto& t : threads)
+    t.join();
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+void EnumerateFileList(const string& fileListPath, const function<void(const string&)>& onFile) {
+  ifstream ifs(FILENAME_STRING(fileListPath));
+  if (ifs.fail())
+    throw runtime_error("Failed to read path: " + fileListPath);
+
+  string line;
+  while (getline(ifs, line)) {
+    if (!line.empty() && line[line.size() - 1] == '\r')
+      line.erase(line.size() - 1);
+    if (!line.empty())
+      onFile(line);
+  }
+}
+
+} // namespace file
+} // namespace sample
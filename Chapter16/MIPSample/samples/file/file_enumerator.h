@@ -0,0 +1,68 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLE_FILE_ENUMERATOR_H_
+#define SAMPLE_FILE_ENUMERATOR_H_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace sample {
+namespace file {
+
+// Called with a directory below the root that could not be listed and the reason
+typedef std::function<void(const std::string& directory, const std::string& error)> DirectoryErrorCallback;
+
+// Walks a directory tree and calls onFile for every regular file found. Each
+// directory is listed completely before any of its files are reported, so
+// output files written next to their inputs are never picked up by the walk.
+// Symbolic links to directories are not followed.
+// If the root cannot be listed this throws. A subdirectory that cannot be listed is passed to onDirectoryError and
+// the walk goes on without it; without onDirectoryError it ends the walk with an exception too.
+void EnumerateDirectory(
+    const std::string& directory,
+    const std::function<void(const std::string&)>& onFile,
+    const DirectoryErrorCallback& onDirectoryError = nullptr);
+
+// Same walk as EnumerateDirectory, but directories are listed by threadCount threads at once. onFile and
+// onDirectoryError are called concurrently from those threads and must be thread-safe. If the root, or without
+// onDirectoryError any directory, cannot be listed the walk stops and the error is rethrown once all threads are done.
+void EnumerateDirectoryParallel(
+    const std::string& directory,
+    size_t threadCount,
+    const std::function<void(const std::string&)>& onFile,
+    const DirectoryErrorCallback& onDirectoryError = nullptr);
+
+// Reads a list of file paths, one per line, and calls onFile for each of them.
+// Empty lines are skipped.
+void EnumerateFileList(const std::string& fileListPath, const std::function<void(const std::string&)>& onFile);
+
+} // namespace file
+} // namespace sample
+
+#endif // SAMPLE_FILE_ENUMERATOR_H_
@@ -0,0 +1,242 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "label_index.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using mip::FileEngine;
+using mip::Label;
+using std::lock_guard;
+using std::mutex;
+using std::runtime_error;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace sample {
+namespace file {
+
+LabelIndex::LabelIndex(const vector<shared_ptr<Label>>& labels) {
+  for (const auto& label : labels)
+    Add(label, vector<shared_ptr<Label>>());
+
+  // Entries no longer move once the tree has been walked, so pointers into mEntries stay valid
+  mBySensitivity.reserve(mEntries.size());
+  for (const auto& entry : mEntries)
+    mBySensitivity.push_back(&entry);
+
+  // Compare the sensitivities along the path from the root, so children sort within their parent
+  std::stable_sort(mBySensitivity.begin(), mBySensitivity.end(), [](const Entry* a, const Entry* b) {
+    const size_t depth = std::min(a->depth, b->depth);
+    for (size_t i = 0; i < depth; i++) {
+      if (a->parents[i] != b->parents[i])
+        return a->parents[i]->GetSensitivity() < b->parents[i]->GetSensitivity();
+    }
+    const Label& left = a->depth == depth ? *a->label : *a->parents[depth];
+    const Label& right = b->depth == depth ? *b->label : *b->parents[depth];
+    if (&left != &right)
+      return left.GetSensitivity() < right.GetSensitivity();
+    // One is an ancestor of the other
+    return a->depth < b->depth;
+  });
+
+  for (size_t i = 0; i < mBySensitivity.size(); i++)
+    mEntries[mBySensitivity[i] - &mEntries[0]].rank = i;
+}
+
+void LabelIndex::Add(const shared_ptr<Label>& label, const vector<shared_ptr<Label>>& parents) {
+  Entry entry;
+  entry.label = label;
+  entry.parents = parents;
+  entry.depth = parents.size();
+
+  const size_t position = mEntries.size();
+  mEntries.push_back(entry);
+  mIdLookup.emplace(label->GetId(), position);
+  mNameLookup[label->GetName()].push_back(position);
+  // A top-level label's path is its name, which is already indexed
+  if (!parents.empty())
+    mNameLookup[GetPath(entry)].push_back(position);
+
+  const auto& children = label->GetChildren();
+  if (children.empty())
+    return;
+
+  vector<shared_ptr<Label>> childParents(parents);
+  childParents.push_back(label);
+  for (const auto& child : children)
+    Add(child, childParents);
+}
+
+const LabelIndex::Entry* LabelIndex::FindById(const string& id) const {
+  auto it = mIdLookup.find(id);
+  return it == mIdLookup.end() ? nullptr : &mEntries[it->second];
+}
+
+const LabelIndex::Entry* LabelIndex::FindByName(const string& nameOrPath) const {
+  auto it = mNameLookup.find(nameOrPath);
+  return it == mNameLookup.end() || it->second.size() != 1 ? nullptr : &mEntries[it->second.front()];
+}
+
+vector<const LabelIndex::Entry*> LabelIndex::FindAllByName(const string& nameOrPath) const {
+  vector<const Entry*> entries;
+  auto it = mNameLookup.find(nameOrPath);
+  if (it != mNameLookup.end()) {
+    for (size_t position : it->second)
+      entries.push_back(&mEntries[position]);
+  }
+  return entries;
+}
+
+const LabelIndex::Entry& LabelIndex::Resolve(const string& idOrName) const {
+  const Entry* entry = FindById(idOrName);
+  if (entry)
+    return *entry;
+
+  const auto candidates = FindAllByName(idOrName);
+  if (candidates.empty())
+    throw runtime_error("No label with ID or name: " + idOrName);
+  if (candidates.size() > 1) {
+    // Picking one would silently apply a label of the wrong sensitivity
+    string message = "Several labels are named " + idOrName + ", use an ID or a Parent\\Label path:";
+    for (const Entry* candidate : candidates)
+      message += "\n  " + GetPath(*candidate) + " (" + candidate->label->GetId() + ")";
+    throw runtime_error(message);
+  }
+  return *candidates.front();
+}
+
+string LabelIndex::GetPath(const Entry& entry) {
+  string path;
+  for (const auto& parent : entry.parents)
+    path += parent->GetName() + "\\";
+  return path + entry.label->GetName();
+}
+
+namespace {
+
+string GetParentId(const LabelIndex::Entry& entry) {
+  return entry.parents.empty() ? string() : entry.parents.back()->GetId();
+}
+
+bool IsSameLabel(const LabelIndex::Entry& before, const LabelIndex::Entry& after) {
+  const Label& a = *before.label;
+  const Label& b = *after.label;
+  return a.GetName() == b.GetName() &&
+      a.GetDescription() == b.GetDescription() &&
+      a.GetColor() == b.GetColor() &&
+      a.GetTooltip() == b.GetTooltip() &&
+      a.GetSensitivity() == b.GetSensitivity() &&
+      a.IsActive() == b.IsActive() &&
+      GetParentId(before) == GetParentId(after);
+}
+
+} // namespace
+
+bool LabelChangeSet::Affects(const string& labelId) const {
+  return std::find(removed.begin(), removed.end(), labelId) != removed.end() ||
+      std::find(changed.begin(), changed.end(), labelId) != changed.end();
+}
+
+LabelChangeSet DiffLabelIndexes(const LabelIndex& before, const LabelIndex& after) {
+  LabelChangeSet changes;
+  for (const auto& entry : after.GetLabels()) {
+    const auto& id = entry.label->GetId();
+    const LabelIndex::Entry* previous = before.FindById(id);
+    if (!previous)
+      changes.added.push_back(id);
+    else if (!IsSameLabel(*previous, entry))
+      changes.changed.push_back(id);
+  }
+  for (const auto& entry : before.GetLabels()) {
+    if (!after.FindById(entry.label->GetId()))
+      changes.removed.push_back(entry.label->GetId());
+  }
+  return changes;
+}
+
+LiveLabelIndex::LiveLabelIndex(const shared_ptr<FileEngine>& fileEngine)
+  : mFileEngine(fileEngine),
+    mIndex(std::make_shared<const LabelIndex>(fileEngine->ListSensitivityLabels())) {
+}
+
+LabelChangeSet LiveLabelIndex::Reload() {
+  lock_guard<mutex> lock(mReloadMutex);
+  auto fileEngine = mFileEngine.lock();
+  if (!fileEngine)
+    return LabelChangeSet();
+
+  shared_ptr<const LabelIndex> index = std::make_shared<const LabelIndex>(fileEngine->ListSensitivityLabels());
+  const auto previous = std::atomic_load(&mIndex);
+  LabelChangeSet changes = DiffLabelIndexes(*previous, *index);
+  std::atomic_store(&mIndex, index);
+  return changes;
+}
+
+shared_ptr<LiveLabelIndex> LabelIndexCache::Get(const shared_ptr<FileEngine>& fileEngine) {
+  const string engineId = fileEngine->GetSettings().GetEngineId();
+  {
+    lock_guard<mutex> lock(mMutex);
+    auto it = mIndexes.find(engineId);
+    if (it != mIndexes.end())
+      return it->second;
+  }
+
+  // Build outside the lock. If two threads race, both indexes describe the same policy and the first one stored wins.
+  auto index = std::make_shared<LiveLabelIndex>(fileEngine);
+  lock_guard<mutex> lock(mMutex);
+  return mIndexes.emplace(engineId, index).first->second;
+}
+
+void LabelIndexCache::OnPolicyChanged(const string& engineId) {
+  shared_ptr<LiveLabelIndex> index;
+  vector<Listener> listeners;
+  {
+    lock_guard<mutex> lock(mMutex);
+    auto it = mIndexes.find(engineId);
+    if (it == mIndexes.end())
+      return; // Nobody has asked for this engine's labels yet, the first Get will see the new policy
+    index = it->second;
+    listeners = mListeners;
+  }
+
+  const LabelChangeSet changes = index->Reload();
+  if (changes.IsEmpty())
+    return;
+  for (const auto& listener : listeners)
+    listener(engineId, changes);
+}
+
+void LabelIndexCache::AddListener(const Listener& listener) {
+  lock_guard<mutex> lock(mMutex);
+  mListeners.push_back(listener);
+}
+
+} // namespace file
+} // namespace sample
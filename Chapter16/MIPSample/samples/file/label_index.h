@@ -0,0 +1,150 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLE_LABEL_INDEX_H_
+#define SAMPLE_LABEL_INDEX_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mip/file/file_engine.h"
+#include "mip/upe/label.h"
+
+namespace sample {
+namespace file {
+
+// Flat, read-only view of the label tree returned by FileEngine::ListSensitivityLabels. The tree is walked once on
+// construction; afterwards labels are resolved by ID or name with a hash lookup, and parent chains and sensitivity
+// ranks are precomputed. An index is immutable and may be shared between threads.
+class LabelIndex final {
+public:
+  struct Entry {
+    std::shared_ptr<mip::Label> label;
+    std::vector<std::shared_ptr<mip::Label>> parents; // Root first, not including the label itself
+    size_t depth = 0; // Number of parents
+    size_t rank = 0; // Position in GetLabelsBySensitivity(), higher is more sensitive
+  };
+
+  explicit LabelIndex(const std::vector<std::shared_ptr<mip::Label>>& labels);
+
+  // Return nullptr if no label matches. Names are not unique across parents ("Recipients Only" may exist under
+  // several labels), so FindByName also accepts the path of a label, its parents' names and its own separated by
+  // backslashes ("Confidential\Recipients Only"), and returns nullptr for a name or path carried by several labels.
+  const Entry* FindById(const std::string& id) const;
+  const Entry* FindByName(const std::string& nameOrPath) const;
+  // Every label with this name or path, in tree order
+  std::vector<const Entry*> FindAllByName(const std::string& nameOrPath) const;
+
+  // Resolves idOrName as an ID first and as a name or path otherwise. Throws std::runtime_error if nothing matches,
+  // or if several labels do, listing their paths and IDs.
+  const Entry& Resolve(const std::string& idOrName) const;
+
+  // Names of the parents and of the label, separated by backslashes
+  static std::string GetPath(const Entry& entry);
+
+  // Every label of the tree in depth-first order, parents before their children.
+  const std::vector<Entry>& GetLabels() const { return mEntries; }
+
+  // Every label from least to most sensitive. Sublabels are ordered inside their parent, so a sublabel never ranks
+  // below a less sensitive top-level label.
+  const std::vector<const Entry*>& GetLabelsBySensitivity() const { return mBySensitivity; }
+
+private:
+  void Add(const std::shared_ptr<mip::Label>& label, const std::vector<std::shared_ptr<mip::Label>>& parents);
+
+  std::vector<Entry> mEntries;
+  std::vector<const Entry*> mBySensitivity;
+  std::unordered_map<std::string, size_t> mIdLookup;
+  std::unordered_map<std::string, std::vector<size_t>> mNameLookup; // Names and paths
+};
+
+// Labels that differ between two indexes of the same engine, by label ID
+struct LabelChangeSet {
+  std::vector<std::string> added;
+  std::vector<std::string> removed;
+  std::vector<std::string> changed; // Name, description, color, tooltip, sensitivity, active state or parent differ
+
+  bool IsEmpty() const { return added.empty() && removed.empty() && changed.empty(); }
+  // True if labelId was removed or changed, i.e. anything derived from it is stale
+  bool Affects(const std::string& labelId) const;
+};
+
+LabelChangeSet DiffLabelIndexes(const LabelIndex& before, const LabelIndex& after);
+
+// The current LabelIndex of one engine. Readers call Get() and keep using the index they got for as long as they like;
+// Reload() builds a new index off to the side and publishes it with an atomic pointer swap, so readers never wait for
+// a reload to finish and never see a half-built index (read-copy-update). Get() is not lock-free: the standard library
+// may guard the shared_ptr copy with an internal lock, which is only held for that copy.
+class LiveLabelIndex final {
+public:
+  explicit LiveLabelIndex(const std::shared_ptr<mip::FileEngine>& fileEngine);
+
+  LiveLabelIndex(const LiveLabelIndex&) = delete;
+  LiveLabelIndex& operator=(const LiveLabelIndex&) = delete;
+
+  std::shared_ptr<const LabelIndex> Get() const { return std::atomic_load(&mIndex); }
+
+  // Rebuilds the index from the engine's current labels and returns what changed. Returns an empty change set if the
+  // engine no longer exists.
+  LabelChangeSet Reload();
+
+private:
+  std::weak_ptr<mip::FileEngine> mFileEngine;
+  std::shared_ptr<const LabelIndex> mIndex; // Only accessed through std::atomic_load/atomic_store
+  std::mutex mReloadMutex; // Serializes reloads, readers only contend with the pointer swap at its end
+};
+
+// Keeps one LiveLabelIndex per engine. Forward FileProfile::Observer::OnPolicyChanged to OnPolicyChanged: the engine's
+// index is rebuilt and swapped in, and listeners learn which labels changed so they can drop only the derived state
+// that refers to them. Thread-safe.
+class LabelIndexCache final {
+public:
+  typedef std::function<void(const std::string& engineId, const LabelChangeSet& changes)> Listener;
+
+  // Registers fileEngine on first use. Hold on to the result to read the index without touching the cache.
+  std::shared_ptr<LiveLabelIndex> Get(const std::shared_ptr<mip::FileEngine>& fileEngine);
+
+  void OnPolicyChanged(const std::string& engineId);
+
+  // Listeners run on the thread that delivered OnPolicyChanged, and only when something changed
+  void AddListener(const Listener& listener);
+
+private:
+  std::mutex mMutex;
+  std::map<std::string, std::shared_ptr<LiveLabelIndex>> mIndexes;
+  std::vector<Listener> mListeners;
+};
+
+} // namespace file
+} // namespace sample
+
+#endif // SAMPLE_LABEL_INDEX_H_
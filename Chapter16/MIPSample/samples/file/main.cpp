@@ -25,11 +25,19 @@
  *
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 #ifdef __linux__
 #include <unistd.h>
@@ -40,9 +48,17 @@
 
 #include "cxxopts.hpp"
 
+#include "async_file_operations.h"
+#include "async_ring_logger.h"
+#include "audit_batcher.h"
 #include "auth_delegate_impl.h"
+#include "commit_pipeline.h"
 #include "consent_delegate_impl.h"
+#include "content_classifier.h"
+#include "file_enumerator.h"
 #include "file_handler_observer.h"
+#include "label_index.h"
+#include "mapped_file_stream.h"
 #include "mip/common_types.h"
 #include "mip/version.h"
 #include "mip/file/file_handler.h"
@@ -53,8 +69,20 @@
 #include "mip/upe/policy_engine.h"
 #include "mip/user_rights.h"
 #include "mip/protection/protection_handler.h"
+#include "ndjson_writer.h"
+#ifndef _WIN32
+#include "pooled_http_delegate.h"
+#endif // _WIN32
+#include "policy_snapshot.h"
 #include "profile_observer.h"
+#include "recording_http_delegate.h"
+#include "replay_http_delegate.h"
+#include "retry_scheduler.h"
+#ifndef _WIN32
+#include "shared_token_cache.h"
+#endif // _WIN32
 #include "string_utils.h"
+#include "thread_pool.h"
 
 using mip::ActionSource;
 using mip::AssignmentMethod;
@@ -70,26 +98,59 @@ using mip::ProtectionHandler;
 using mip::LabelingOptions;
 using mip::UserRights;
 using sample::auth::AuthDelegateImpl;
+using sample::classification::ContentClassifier;
 using sample::consent::ConsentDelegateImpl;
+using sample::file::AuditBatcher;
+using sample::file::Completion;
+using sample::file::EnumerateDirectory;
+using sample::file::EnumerateDirectoryParallel;
+using sample::file::EnumerateFileList;
+using sample::file::LabelIndex;
+using sample::file::LabelIndexCache;
+using sample::file::PolicySnapshot;
+#ifndef _WIN32
+using sample::http::PooledHttpDelegate;
+#endif // _WIN32
+using sample::http::RecordingHttpDelegate;
+using sample::http::ReplayHttpDelegate;
+using sample::logging::AsyncRingLogger;
+using sample::utils::AppendJsonString;
+using sample::utils::ClassifyFailure;
+using sample::utils::FailureKind;
+using sample::utils::MappedFileStream;
+using sample::utils::NdjsonWriter;
+using sample::utils::RetryPolicy;
+using sample::utils::RetryScheduler;
+using sample::utils::ThreadPool;
+using std::atomic;
 using std::cout;
 using std::cin;
+using std::condition_variable;
 using std::endl;
+using std::exception_ptr;
 using std::getline;
 using std::istream;
 using std::ifstream;
+using std::lock_guard;
 using std::make_shared;
+using std::mutex;
+using std::ostream;
+using std::ofstream;
 using std::ostringstream;
 using std::ostream_iterator;
 using std::shared_ptr;
 using std::static_pointer_cast;
 using std::string;
 using std::stringstream;
+using std::unique_lock;
 using std::vector;
 using std::pair;
 
 namespace {
 
 static const string kApplicationName = "Microsoft Information Protection File SDK Sample";
+static const string kInMemoryStoragePath = "file_sample_storage";
+static const string kEngineRegistryFileName = "file_sample_engines.txt";
 
 static const char kPathSeparatorWindows = '\\';
 static const char kPathSeparatorUnix = '/';
@@ -128,62 +189,203 @@ bool EqualsIgnoreCase(const string& a, const string& b) {
   return true;
 }
 
-// Get the current label and protection on this file and print to console label and protection information
+// Prints the sensitive information found in the file's stored bytes
+void PrintSensitiveInfo(const ContentClassifier& classifier, const string& filePath, ostream& out) {
+  const auto classification = classifier.ScanFile(filePath);
+  if (classification.GetAllResults().empty()) {
+    out << "Sensitive information: none found" << endl;
+    return;
+  }
+  for (const auto& type : classifier.GetTypes()) {
+    auto it = classification.GetAllResults().find(type.id);
+    if (it != classification.GetAllResults().end()) {
+      out << "Sensitive information: " << type.name << ", count " << it->second->GetCount() << ", confidence "
+          << it->second->GetConfidenceLevel() << endl;
+    }
+  }
+}
+
+// Get the current label and protection on this file and print label and protection information to out
 void GetLabel(
-  const shared_ptr<FileHandler>& fileHandler) {
+  const shared_ptr<FileHandler>& fileHandler,
+  ostream& out) {
   auto protection = fileHandler->GetProtection(); // Get the current protection on the file
   auto label = fileHandler->GetLabel(); //Get the current label on the file
 
   if (!label && !protection) {
-    cout << "File is neither labeled nor protected" << endl;
+    out << "File is neither labeled nor protected" << endl;
     return;
   }
 
   if (label) {
     bool isPrivileged = label->GetAssignmentMethod() == AssignmentMethod::PRIVILEGED;
     auto extendedProperties = label->GetExtendedProperties();
-    cout << "File is labeled as: " << label->GetLabel()->GetName() << endl;
-    cout << "Id: " << label->GetLabel()->GetId() << endl;
+    out << "File is labeled as: " << label->GetLabel()->GetName() << endl;
+    out << "Id: " << label->GetLabel()->GetId() << endl;
 
     if (const shared_ptr<mip::Label> parent = label->GetLabel()->GetParent().lock()) {
-      cout << "Parent label: " << parent->GetName() << endl;
-      cout << "Parent Id: " << parent->GetId() << endl;
+      out << "Parent label: " << parent->GetName() << endl;
+      out << "Parent Id: " << parent->GetId() << endl;
     }
-    cout << "Set time: " << label->GetCreationTime() << endl;
-    cout << "Privileged: " << (isPrivileged ? "True" : "False") << endl;
+    out << "Set time: " << label->GetCreationTime() << endl;
+    out << "Privileged: " << (isPrivileged ? "True" : "False") << endl;
     if (!extendedProperties.empty()) {
-      cout << "Extended Properties: " << endl;
+      out << "Extended Properties: " << endl;
     }
     for (size_t j = 0; j < extendedProperties.size(); j++) {
-      cout << "Key: " << extendedProperties[j].first << ", Value: " << extendedProperties[j].second << endl;
+      out << "Key: " << extendedProperties[j].first << ", Value: " << extendedProperties[j].second << endl;
     }
 
   } else
-    cout << "File is not labeled" << endl;
+    out << "File is not labeled" << endl;
 
   if (protection) {
-    cout << "File is protected with ";
+    out << "File is protected with ";
 
     const shared_ptr<ProtectionDescriptor> protectionDescriptor = protection->GetProtectionDescriptor();
     if (protectionDescriptor->GetProtectionType() == mip::ProtectionType::TemplateBased)
-      cout << "template." << endl;
+      out << "template." << endl;
     else
-      cout << "custom permissions." << endl;
+      out << "custom permissions." << endl;
 
-    cout << "Name: " << protectionDescriptor->GetName() << endl;
-    cout << "Template Id: " << protectionDescriptor->GetTemplateId() << endl;
+    out << "Name: " << protectionDescriptor->GetName() << endl;
+    out << "Template Id: " << protectionDescriptor->GetTemplateId() << endl;
     for (const auto& usersRights : protectionDescriptor->GetUserRights()) {
-      cout << "Rights: ";
+      out << "Rights: ";
       auto rights = usersRights.Rights();
-      copy(rights.cbegin(), rights.cend() - 1, ostream_iterator<string>(cout, ", "));
-      cout << *rights.crbegin() << endl;
+      if (!rights.empty()) {
+        copy(rights.cbegin(), rights.cend() - 1, ostream_iterator<string>(out, ", "));
+        out << *rights.crbegin();
+      }
+      out << endl;
 
-      cout << "For Users: ";
+      out << "For Users: ";
       auto users = usersRights.Users();
-      copy(users.cbegin(), users.cend() - 1, ostream_iterator<string>(cout, "; "));
-      cout << *users.crbegin() << endl;
+      if (!users.empty()) {
+        copy(users.cbegin(), users.cend() - 1, ostream_iterator<string>(out, "; "));
+        out << *users.crbegin();
+      }
+      out << endl;
+    }
+  }
+}
+
+const char* GetAssignmentMethodName(AssignmentMethod method) {
+  switch (method) {
+    case AssignmentMethod::PRIVILEGED: return "privileged";
+    case AssignmentMethod::AUTO: return "auto";
+    case AssignmentMethod::STANDARD:
+    default: return "standard";
+  }
+}
+
+void AppendJsonStringArray(string& out, const vector<string>& values) {
+  out += '[';
+  for (size_t i = 0; i < values.size(); i++) {
+    if (i > 0)
+      out += ',';
+    AppendJsonString(out, values[i]);
+  }
+  out += ']';
+}
+
+// Same information as GetLabel, as a single-line JSON record. Absent label or protection are written as null. With a
+// classifier the record also lists the sensitive information found, like PrintSensitiveInfo.
+string GetLabelJson(
+    const shared_ptr<FileHandler>& fileHandler,
+    const string& filePath,
+    const ContentClassifier* classifier) {
+  auto protection = fileHandler->GetProtection();
+  auto label = fileHandler->GetLabel();
+
+  string json = "{\"path\":";
+  AppendJsonString(json, filePath);
+
+  json += ",\"label\":";
+  if (label) {
+    json += "{\"id\":";
+    AppendJsonString(json, label->GetLabel()->GetId());
+    json += ",\"name\":";
+    AppendJsonString(json, label->GetLabel()->GetName());
+    json += ",\"parentId\":";
+    if (const shared_ptr<mip::Label> parent = label->GetLabel()->GetParent().lock())
+      AppendJsonString(json, parent->GetId());
+    else
+      json += "null";
+    json += ",\"setTime\":";
+    AppendJsonString(json, label->GetCreationTime());
+    json += ",\"assignmentMethod\":\"";
+    json += GetAssignmentMethodName(label->GetAssignmentMethod());
+    json += "\",\"extendedProperties\":{";
+    const auto& extendedProperties = label->GetExtendedProperties();
+    for (size_t i = 0; i < extendedProperties.size(); i++) {
+      if (i > 0)
+        json += ',';
+      AppendJsonString(json, extendedProperties[i].first);
+      json += ':';
+      AppendJsonString(json, extendedProperties[i].second);
+    }
+    json += "}}";
+  } else {
+    json += "null";
+  }
+
+  json += ",\"protection\":";
+  if (protection) {
+    const shared_ptr<ProtectionDescriptor> protectionDescriptor = protection->GetProtectionDescriptor();
+    json += "{\"type\":\"";
+    json += protectionDescriptor->GetProtectionType() == mip::ProtectionType::TemplateBased ? "template" : "custom";
+    json += "\",\"name\":";
+    AppendJsonString(json, protectionDescriptor->GetName());
+    json += ",\"templateId\":";
+    AppendJsonString(json, protectionDescriptor->GetTemplateId());
+    json += ",\"userRights\":[";
+    bool first = true;
+    for (const auto& usersRights : protectionDescriptor->GetUserRights()) {
+      if (!first)
+        json += ',';
+      first = false;
+      json += "{\"users\":";
+      AppendJsonStringArray(json, usersRights.Users());
+      json += ",\"rights\":";
+      AppendJsonStringArray(json, usersRights.Rights());
+      json += '}';
+    }
+    json += "]}";
+  } else {
+    json += "null";
+  }
+
+  if (classifier) {
+    const auto classification = classifier->ScanFile(filePath);
+    json += ",\"sensitiveInfo\":[";
+    bool first = true;
+    for (const auto& type : classifier->GetTypes()) {
+      auto it = classification.GetAllResults().find(type.id);
+      if (it == classification.GetAllResults().end())
+        continue;
+      if (!first)
+        json += ',';
+      first = false;
+      json += "{\"type\":";
+      AppendJsonString(json, type.name);
+      json += ",\"count\":" + std::to_string(it->second->GetCount());
+      json += ",\"confidence\":" + std::to_string(it->second->GetConfidenceLevel()) + '}';
     }
+    json += ']';
   }
+
+  json += '}';
+  return json;
+}
+
+string GetErrorJson(const string& filePath, const string& message) {
+  string json = "{\"path\":";
+  AppendJsonString(json, filePath);
+  json += ",\"error\":";
+  AppendJsonString(json, message);
+  json += '}';
+  return json;
 }
 
 string CreateOutput(FileHandler* fileHandler) {
@@ -199,7 +401,31 @@ string CreateOutput(FileHandler* fileHandler) {
   return outputFileNameWithoutExtension + "_modified" + fileExtension;
 }
 
-void SetLabel(
+// Reports the outcome of a commit to out, or removes the unused output file when nothing was committed.
+// With an auditBatcher the audit event is queued rather than sent before returning.
+void ReportCommit(
+  const shared_ptr<FileHandler>& fileHandler,
+  const string& outputFilePath,
+  bool committed,
+  bool notifyAudit,
+  AuditBatcher* auditBatcher,
+  ostream& out) {
+  if (committed) {
+    out << "New file created: " << outputFilePath << endl;
+    if (notifyAudit && auditBatcher) {
+      auditBatcher->NotifyCommitSuccessful(fileHandler, outputFilePath);
+    } else if (notifyAudit) {
+      //Triggers audit event
+      fileHandler->NotifyCommitSuccessful(outputFilePath);
+    }
+  } else {
+    if (remove(outputFilePath.c_str()) != 0) {
+      throw std::runtime_error("unable to delete outputfile");
+    }
+  }
+}
+
+void ApplyLabel(
   const shared_ptr<FileHandler>& fileHandler,
   const string& labelId,
   AssignmentMethod method,
@@ -215,57 +441,13 @@ void SetLabel(
   } else {
     fileHandler->SetLabel(labelId, labelingOptions); // Set a label with label Id to the file
   }
-
-  auto outputFilePath = CreateOutput(fileHandler.get());
-
-  auto commitPromise = make_shared<std::promise<bool>>();
-  auto commitFuture = commitPromise->get_future();
-  fileHandler->CommitAsync(outputFilePath, commitPromise);
-  auto committed = commitFuture.get();
-
-  if (committed) {
-    cout << "New file created: " << outputFilePath << endl;
-    //Triggers audit event
-    fileHandler->NotifyCommitSuccessful(outputFilePath);
-  } else {
-    if (remove(outputFilePath.c_str()) != 0) {
-      throw std::runtime_error("unable to delete outputfile");
-    }
-  }
 }
 
-void Unprotect(
-  const shared_ptr<FileHandler>& fileHandler,
-  const string& filePath) {
-
-    cout << filePath << endl;
-  auto isProtected = FileHandler::IsProtected(filePath);
-  // Note that only checking if the file is protected does not require any network IO or auth
-  if (!isProtected) {
-    cout << "File is not protected, no change made." << endl;
-    return;
-  }
-
-  fileHandler->RemoveProtection(); // Remove the protection from the file
-  auto outputFilePath = CreateOutput(fileHandler.get());
-
-  auto commitPromise = make_shared<std::promise<bool>>();
-  auto commitFuture = commitPromise->get_future();
-  fileHandler->CommitAsync(outputFilePath, commitPromise);
-  auto committed = commitFuture.get();
-
-  if (committed) {
-    cout << "New file created: " << outputFilePath << endl;
-  } else {
-    if (remove(outputFilePath.c_str()) != 0) {
-      throw std::runtime_error("unable to delete outputfile");
-    }
-  }
-}
-
-// Print the labels and sublabels to the console
-void ListLabels(const vector<shared_ptr<mip::Label>>& labels, const string& delimiter = "") {
-  for (const auto& label : labels) {
+// Print the labels and sublabels to the console. The index already lists them depth-first, parents before children.
+void ListLabels(const LabelIndex& labelIndex) {
+  for (const auto& entry : labelIndex.GetLabels()) {
+    const auto& label = entry.label;
+    const string delimiter(entry.depth * 2, ' ');
     const string labelDescription = 
       label->GetDescription().size() < 70 ?
       label->GetDescription() :
@@ -275,38 +457,13 @@ void ListLabels(const vector<shared_ptr<mip::Label>>& labels, const string& deli
         delimiter << "Label name: " << label->GetName() << "\n" <<
         delimiter << "Label description: " << labelDescription << "\n" << endl;
     
-    const vector<shared_ptr<mip::Label>>& childLabels = label->GetChildren();
-    if (!childLabels.empty()) {
+    if (!label->GetChildren().empty())
       cout << delimiter << "Child labels:" << endl;
-      ListLabels(childLabels, delimiter + "  ");
-    }
   }
 }
 
-void ProtectWithPermissions(
-  const shared_ptr<FileHandler>& fileHandler,
-  const shared_ptr<ProtectionDescriptorBuilder> descriptorBuilder) {
-  const auto protectionDescriptor = descriptorBuilder->Build();
-  fileHandler->SetProtection(protectionDescriptor);
-  auto outputFilePath = CreateOutput(fileHandler.get());
-
-  auto commitPromise = make_shared<std::promise<bool>>();
-  auto commitFuture = commitPromise->get_future();
-  fileHandler->CommitAsync(outputFilePath, commitPromise);
-  auto committed = commitFuture.get();
-
-  if (committed) {
-    cout << "New file created: " << outputFilePath << endl;
-  } else {
-    if (remove(outputFilePath.c_str()) != 0) {
-      throw std::runtime_error("unable to delete outputfile");
-    }
-  }
-}
-
-void ProtectWithCustomPermissions(
-  const shared_ptr<FileHandler>& fileHandler,
-  const string& usersList, 
+shared_ptr<ProtectionDescriptorBuilder> CreateCustomPermissionsBuilder(
+  const string& usersList,
   const string& rightsList) {
   vector<string> userList;
   stringstream usersListstream(usersList);
@@ -327,7 +484,7 @@ void ProtectWithCustomPermissions(
   }
 
   const UserRights usersRights(userList, rightList);
-  ProtectWithPermissions(fileHandler, ProtectionDescriptorBuilder::CreateFromUserRights(vector<UserRights>({ usersRights })));
+  return ProtectionDescriptorBuilder::CreateFromUserRights(vector<UserRights>({ usersRights }));
 }
 
 string ReadPolicyFile(const string& policyPath) {
@@ -335,25 +492,71 @@ string ReadPolicyFile(const string& policyPath) {
   if (ifs.fail())
     throw std::runtime_error("Failed to read path: " + policyPath);
 
-  cout << "Using policy from file: " << policyPath << endl;
+  // Read straight into a string of the right size instead of growing an ostringstream and copying it out
+  ifs.seekg(0, std::ios::end);
+  const auto size = ifs.tellg();
+  ifs.seekg(0, std::ios::beg);
+  string policyContent(size > 0 ? static_cast<size_t>(size) : 0, '\0');
+  if (!policyContent.empty() && !ifs.read(&policyContent[0], policyContent.size()))
+    throw std::runtime_error("Failed to read path: " + policyPath);
+  return policyContent;
+}
+
+// Same output as ListLabels, answered from a compiled snapshot of the local policy without a profile or engine
+void ListLabelsFromSnapshot(const string& policyPath, const string& locale, const string& snapshotPath) {
+  bool compiled = false;
+  const auto snapshot = PolicySnapshot::LoadOrCompile(policyPath, locale, snapshotPath, compiled);
+  cout << (compiled ? "Compiled policy snapshot: " : "Using policy snapshot: ") << snapshotPath << endl;
+
+  const auto& labels = snapshot.GetLabels();
+  vector<size_t> depths(labels.size(), 0);
+  for (size_t i = 0; i < labels.size(); i++) {
+    const auto& label = labels[i];
+    // Parents are stored before their children, so their depth is already known
+    if (label.parent >= 0)
+      depths[i] = depths[label.parent] + 1;
+    const string delimiter(depths[i] * 2, ' ');
+    const string labelDescription =
+      label.description.size() < 70 ?
+      label.description :
+      label.description.substr(0, 70) + "...";
+
+    cout << delimiter << "Label ID: " << label.id << "\n" <<
+        delimiter << "Label name: " << label.name << "\n" <<
+        delimiter << "Label description: " << labelDescription << "\n" << endl;
 
-  ostringstream policyContent;
-  policyContent << ifs.rdbuf();
-  ifs.close();
-  return policyContent.str();
+    const bool hasChildren = i + 1 < labels.size() && labels[i + 1].parent == static_cast<int32_t>(i);
+    if (hasChildren)
+      cout << delimiter << "Child labels:" << endl;
+  }
 }
 
+// With an empty storagePath the profile lives in memory and every run starts cold. Otherwise engines, policy and
+// licenses are persisted under storagePath so that later runs can reload them.
+// Without an httpDelegate the SDK uses its own HTTP stack, without a loggerDelegate its own logger.
+// onPolicyChanged is called with the engine ID whenever the SDK picks up a new policy for that engine.
 shared_ptr<FileProfile> CreateProfile(
     const shared_ptr<mip::AuthDelegate>& authDelegate,
-    const shared_ptr<mip::ConsentDelegate>& consentDelegate) {
-  const shared_ptr<ProfileObserver> sampleProfileObserver = make_shared<ProfileObserver>();
-  const FileProfile::Settings profileSettings(
-      "file_sample_storage",
-      true,
+    const shared_ptr<mip::ConsentDelegate>& consentDelegate,
+    const string& storagePath,
+    const shared_ptr<mip::HttpDelegate>& httpDelegate,
+    const shared_ptr<mip::LoggerDelegate>& loggerDelegate,
+    const std::function<void(const string&)>& onPolicyChanged) {
+  const shared_ptr<ProfileObserver> sampleProfileObserver = make_shared<ProfileObserver>(onPolicyChanged);
+  const bool useInMemoryStorage = storagePath.empty();
+  FileProfile::Settings profileSettings(
+      useInMemoryStorage ? kInMemoryStoragePath : storagePath,
+      useInMemoryStorage,
       authDelegate,
       consentDelegate,
       sampleProfileObserver,
       mip::ApplicationInfo{ "000", "FileSampleApp" , "1.0.0.0"});
+  if (httpDelegate)
+    profileSettings.SetHttpDelegate(httpDelegate);
+  if (loggerDelegate) {
+    profileSettings.SetLoggerDelegate(loggerDelegate);
+    profileSettings.SetMinimumLogLevel(loggerDelegate->GetLogLevel());
+  }
 
   auto loadPromise = make_shared<std::promise<shared_ptr<FileProfile>>>();
   auto loadFuture = loadPromise->get_future();
@@ -361,15 +564,56 @@ shared_ptr<FileProfile> CreateProfile(
   return loadFuture.get();
 }
 
-shared_ptr<FileEngine> GetFileEngine(
-    const shared_ptr<FileProfile>& fileProfile,
-    const string& username,
+string GetEngineRegistryPath(const string& storagePath) {
+  auto last = storagePath[storagePath.size() - 1];
+  if (last == kPathSeparatorWindows || last == kPathSeparatorUnix)
+    return storagePath + kEngineRegistryFileName;
+  return storagePath + kPathSeparatorUnix + kEngineRegistryFileName;
+}
+
+// Engine IDs are opaque, so the sample keeps a small "username<TAB>engineId" registry next to the profile storage
+// to know which persisted engine belongs to which user.
+string FindPersistedEngineId(const shared_ptr<FileProfile>& fileProfile, const string& storagePath, const string& username) {
+  string engineId;
+  ifstream registry(FILENAME_STRING(GetEngineRegistryPath(storagePath)));
+  string line;
+  while (getline(registry, line)) {
+    auto separator = line.find('\t');
+    // Later entries win, so re-registering a user simply appends a line
+    if (separator != string::npos && line.substr(0, separator) == username)
+      engineId = line.substr(separator + 1);
+  }
+
+  if (engineId.empty())
+    return engineId;
+
+  // Only trust the registry if the profile still knows the engine
+  auto listEnginesPromise = make_shared<std::promise<vector<string>>>();
+  auto listEnginesFuture = listEnginesPromise->get_future();
+  fileProfile->ListEnginesAsync(listEnginesPromise);
+  const auto engineIds = listEnginesFuture.get();
+  for (const auto& id : engineIds) {
+    if (id == engineId)
+      return engineId;
+  }
+  return string();
+}
+
+void SavePersistedEngineId(const string& storagePath, const string& username, const string& engineId) {
+  ofstream registry(FILENAME_STRING(GetEngineRegistryPath(storagePath)), std::ios::app);
+  if (registry.fail()) {
+    std::cerr << "Unable to save engine ID to: " << GetEngineRegistryPath(storagePath) << endl;
+    return;
+  }
+  registry << username << '\t' << engineId << '\n';
+}
+
+void ConfigureEngineSettings(
+    FileEngine::Settings& settings,
     const string& protectionBaseUrl,
     const string& policyPath,
     bool exportPolicy,
-    bool protectionOnly,
-    const string& locale) {
-  FileEngine::Settings settings(Identity(username), "" /*clientData*/, locale);
+    bool protectionOnly) {
   settings.SetProtectionCloudEndpointBaseUrl(protectionBaseUrl);
   settings.SetProtectionOnlyEngine(protectionOnly);
 
@@ -379,21 +623,657 @@ shared_ptr<FileEngine> GetFileEngine(
     else
       settings.SetCustomSettings({ { mip::GetCustomSettingPolicyDataName(), ReadPolicyFile(policyPath) } }); //Save the content of the policy in custom setting
   }
+}
 
+shared_ptr<FileEngine> AddEngine(const shared_ptr<FileProfile>& fileProfile, const FileEngine::Settings& settings) {
   auto addEnginePromise = make_shared<std::promise<shared_ptr<FileEngine>>>();
   auto addEngineFuture = addEnginePromise->get_future();
   fileProfile->AddEngineAsync(settings, addEnginePromise); // Getting the engine
   return addEngineFuture.get();
 }
 
-shared_ptr<FileHandler> GetFileHandler(const shared_ptr<FileEngine>& fileEngine, const string& filePath, const ContentState contentState) {
+// When storagePath is set, an engine persisted by an earlier run for the same user is reloaded by its ID (warm start)
+// instead of being bootstrapped from scratch. warmStart reports which of the two happened.
+shared_ptr<FileEngine> GetFileEngine(
+    const shared_ptr<FileProfile>& fileProfile,
+    const string& username,
+    const string& protectionBaseUrl,
+    const string& policyPath,
+    bool exportPolicy,
+    bool protectionOnly,
+    const string& locale,
+    const string& storagePath,
+    bool& warmStart) {
+  warmStart = false;
+
+  if (!storagePath.empty() && !exportPolicy) {
+    const string engineId = FindPersistedEngineId(fileProfile, storagePath, username);
+    if (!engineId.empty()) {
+      FileEngine::Settings settings(engineId, "" /*clientData*/, locale);
+      settings.SetIdentity(Identity(username));
+      ConfigureEngineSettings(settings, protectionBaseUrl, policyPath, exportPolicy, protectionOnly);
+      try {
+        auto fileEngine = AddEngine(fileProfile, settings);
+        warmStart = true;
+        return fileEngine;
+      } catch (const std::exception& ex) {
+        std::cerr << "Unable to load persisted engine " << engineId << ", creating a new one: " << ex.what() << endl;
+      }
+    }
+  }
+
+  FileEngine::Settings settings(Identity(username), "" /*clientData*/, locale);
+  ConfigureEngineSettings(settings, protectionBaseUrl, policyPath, exportPolicy, protectionOnly);
+  auto fileEngine = AddEngine(fileProfile, settings);
+
+  if (!storagePath.empty() && !exportPolicy)
+    SavePersistedEngineId(storagePath, username, fileEngine->GetSettings().GetEngineId());
+  return fileEngine;
+}
+
+shared_ptr<FileHandler> GetFileHandler(
+    const shared_ptr<FileEngine>& fileEngine,
+    const string& filePath,
+    const ContentState contentState,
+    bool useMappedStream = false) {
   auto createFileHandlerPromise = make_shared<std::promise<shared_ptr<FileHandler>>>();
   auto createFileHandlerFuture = createFileHandlerPromise->get_future();
   // Here content identifier is same as the filePath
-  fileEngine->CreateFileHandlerAsync(filePath, filePath, contentState, false /*AuditDiscoveryEnabled*/, make_shared<FileHandlerObserver>(), createFileHandlerPromise); // create the file handler
+  if (useMappedStream) {
+    // Feed the SDK straight from the page cache rather than letting it open and buffer the file itself
+    auto inputStream = make_shared<MappedFileStream>(filePath);
+    fileEngine->CreateFileHandlerAsync(inputStream, filePath, filePath, contentState, false /*AuditDiscoveryEnabled*/, make_shared<FileHandlerObserver>(), createFileHandlerPromise); // create the file handler
+  } else {
+    fileEngine->CreateFileHandlerAsync(filePath, filePath, contentState, false /*AuditDiscoveryEnabled*/, make_shared<FileHandlerObserver>(), createFileHandlerPromise); // create the file handler
+  }
   return createFileHandlerFuture.get();
 }
 
+enum class FileActionType {
+  GetStatus,
+  SetLabel,
+  DeleteLabel,
+  Unprotect,
+  Protect,
+  ProtectWithTemplate,
+};
+
+enum class OutputFormat {
+  Text,
+  Ndjson, // One JSON record per file, only for GetStatus
+};
+
+// The label a run applies, watched for policy updates. Once an update changes or removes it, files not labeled yet
+// fail instead of getting a label that no longer means what the user asked for.
+struct WatchedLabel {
+  mutex labelIdMutex;
+  string labelId;
+  atomic<bool> invalidated{false};
+};
+
+// Everything needed to run one file operation, parsed once from the command line so that
+// the same action can be applied to a single file or to every file of a batch
+struct FileAction {
+  FileActionType type = FileActionType::GetStatus;
+  OutputFormat format = OutputFormat::Text;
+  ContentState contentState = ContentState::REST;
+  bool useMappedStream = false;
+  AssignmentMethod method = AssignmentMethod::STANDARD;
+  string labelId;
+  string justificationMessage;
+  vector<pair<string, string>> extendedProperties;
+  string users;
+  string rights;
+  string templateId;
+  shared_ptr<AuditBatcher> auditBatcher; // Set to take audit events off the commit path
+  shared_ptr<const ContentClassifier> classifier; // Set to report sensitive information with the file status
+  shared_ptr<const WatchedLabel> watchedLabel; // Set with SetLabel to stop applying labelId once the policy changes it
+};
+
+void CheckLabelCurrent(const FileAction& action) {
+  if (action.watchedLabel && action.watchedLabel->invalidated)
+    throw std::runtime_error("Label " + action.labelId + " was changed or removed by a policy update, not applied");
+}
+
+// Makes the changes of action on an open handler without committing them. Returns whether there is anything to
+// commit; notifyAudit tells whether the commit should fire an audit event.
+bool PrepareFileAction(
+    const shared_ptr<FileHandler>& fileHandler,
+    const string& filePath,
+    const FileAction& action,
+    ostream& out,
+    bool& notifyAudit) {
+  notifyAudit = false;
+  switch (action.type) {
+    case FileActionType::SetLabel:
+      CheckLabelCurrent(action);
+      ApplyLabel(fileHandler, action.labelId, action.method, action.justificationMessage, action.extendedProperties);
+      notifyAudit = true;
+      return true;
+    case FileActionType::DeleteLabel:
+      // ApplyLabel without labelId delete the label
+      ApplyLabel(fileHandler, "", action.method, action.justificationMessage, vector<pair<string, string>>());
+      notifyAudit = true;
+      return true;
+    case FileActionType::Unprotect:
+      out << filePath << endl;
+      // Note that only checking if the file is protected does not require any network IO or auth
+      if (!FileHandler::IsProtected(filePath)) {
+        out << "File is not protected, no change made." << endl;
+        return false;
+      }
+      fileHandler->RemoveProtection();
+      return true;
+    case FileActionType::Protect:
+      fileHandler->SetProtection(CreateCustomPermissionsBuilder(action.users, action.rights)->Build());
+      return true;
+    case FileActionType::ProtectWithTemplate:
+      fileHandler->SetProtection(ProtectionDescriptorBuilder::CreateFromTemplate(action.templateId)->Build());
+      return true;
+    case FileActionType::GetStatus:
+    default:
+      if (action.format == OutputFormat::Ndjson) {
+        out << GetLabelJson(fileHandler, filePath, action.classifier.get());
+      } else {
+        GetLabel(fileHandler, out);
+        if (action.classifier)
+          PrintSensitiveInfo(*action.classifier, filePath, out);
+      }
+      return false;
+  }
+}
+
+// Runs action on a handler that is already open, committing any change it makes
+void RunFileActionOnHandler(
+    const shared_ptr<FileHandler>& fileHandler,
+    const string& filePath,
+    const FileAction& action,
+    ostream& out) {
+  bool notifyAudit = false;
+  if (!PrepareFileAction(fileHandler, filePath, action, out, notifyAudit))
+    return;
+
+  auto outputFilePath = CreateOutput(fileHandler.get());
+  auto commitPromise = make_shared<std::promise<bool>>();
+  auto commitFuture = commitPromise->get_future();
+  fileHandler->CommitAsync(outputFilePath, commitPromise);
+  ReportCommit(fileHandler, outputFilePath, commitFuture.get(), notifyAudit, action.auditBatcher.get(), out);
+}
+
+void RunFileAction(
+    const shared_ptr<FileEngine>& fileEngine,
+    const string& filePath,
+    const FileAction& action,
+    ostream& out) {
+  // All file actions work on a file handler
+  auto fileHandler = GetFileHandler(fileEngine, filePath, action.contentState, action.useMappedStream);
+  RunFileActionOnHandler(fileHandler, filePath, action, out);
+}
+
+// Reports a directory the walk could not list the way a failed file is reported, so the sweep can go on
+void ReportDirectoryError(
+    const string& directory,
+    const string& error,
+    OutputFormat format,
+    NdjsonWriter& ndjson,
+    mutex& outputMutex) {
+  if (format == OutputFormat::Ndjson) {
+    ndjson.Write(GetErrorJson(directory, error));
+    return;
+  }
+  lock_guard<mutex> lock(outputMutex);
+  cout << "== " << directory << "\nFailed: " << error << "\n";
+}
+
+// Circuit breaker endpoints of RunBatch. SDK errors do not say which service failed, so the two round trips a file
+// makes stand in for the services behind them.
+const char kCreateHandlerEndpoint[] = "create-handler";
+const char kCommitEndpoint[] = "commit";
+
+// Applies the action to every file from the directory walk and/or file list. All workers share
+// one FileEngine; the pool keeps workerCount handlers in flight and blocks the enumeration once
+// queueDepth files are waiting, so memory stays flat regardless of how many files are swept.
+//
+// With a retryScheduler, files that fail with a transient error go back to the scheduler instead of being reported,
+// and come back to the pool once their backoff has passed; while an endpoint's circuit is open, files are parked
+// without calling it. Workers never sleep on a retry, they move on to the next file. A file counts as outstanding
+// from its first submission until it is reported, and the batch ends once none is.
+void RunBatch(
+    const shared_ptr<FileEngine>& fileEngine,
+    const string& directory,
+    const string& fileList,
+    const FileAction& action,
+    size_t workerCount,
+    size_t queueDepth,
+    RetryScheduler* retryScheduler) {
+  mutex outputMutex;
+  atomic<size_t> succeeded(0);
+  atomic<size_t> failed(0);
+  atomic<size_t> failedDirectories(0);
+  mutex outstandingMutex;
+  condition_variable allReported;
+  size_t outstanding = 0;
+  const auto start = std::chrono::steady_clock::now();
+  NdjsonWriter ndjson(stdout);
+
+  {
+    ThreadPool pool(workerCount, queueDepth);
+    // attempt counts the attempts made on filePath before this one
+    std::function<void(const string&, int)> process;
+    auto submitAttempt = [&](const string& filePath, int attempt) {
+      pool.Submit([&, filePath, attempt]() { process(filePath, attempt); });
+    };
+    process = [&](const string& filePath, int attempt) {
+      // claimProbe is false for an endpoint that is only checked now and called later, so its probe stays free
+      auto deferred = [&](const char* endpoint, bool claimProbe) {
+        if (!retryScheduler)
+          return false;
+        const auto holdOff = claimProbe ? retryScheduler->GetHoldOff(endpoint) : retryScheduler->PeekHoldOff(endpoint);
+        if (holdOff.count() == 0)
+          return false;
+        retryScheduler->ScheduleDeferred(holdOff, [&, filePath, attempt]() { submitAttempt(filePath, attempt); });
+        return true;
+      };
+
+      // Buffer per file so output of concurrent workers does not interleave
+      ostringstream fileOutput;
+      string error;
+      const char* endpoint = kCreateHandlerEndpoint;
+      try {
+        // The commit circuit is checked before the handler is created, so a deferral rarely throws away an open
+        // handler. Its probe is only claimed right before committing; should another file claim it in between, this
+        // file is deferred after all.
+        if (deferred(kCommitEndpoint, false) || deferred(kCreateHandlerEndpoint, true))
+          return;
+        auto fileHandler = GetFileHandler(fileEngine, filePath, action.contentState, action.useMappedStream);
+        if (retryScheduler)
+          retryScheduler->RecordSuccess(kCreateHandlerEndpoint);
+
+        endpoint = kCommitEndpoint;
+        if (deferred(kCommitEndpoint, true))
+          return;
+        RunFileActionOnHandler(fileHandler, filePath, action, fileOutput);
+        if (retryScheduler)
+          retryScheduler->RecordSuccess(kCommitEndpoint);
+        succeeded++;
+      } catch (const std::exception& ex) {
+        if (retryScheduler) {
+          const auto kind = ClassifyFailure(ex);
+          if (kind != FailureKind::Permanent)
+            retryScheduler->RecordFailure(endpoint);
+          if (kind == FailureKind::Transient &&
+              retryScheduler->ScheduleRetry(attempt + 1, [&, filePath, attempt]() { submitAttempt(filePath, attempt + 1); }))
+            return;
+        }
+        error = ex.what();
+        failed++;
+      } catch (...) {
+        // Not classifiable, so not retried, but the file must still be reported or the batch never ends
+        error = "unknown error";
+        failed++;
+      }
+
+      if (action.format == OutputFormat::Ndjson) {
+        ndjson.Write(error.empty() ? fileOutput.str() : GetErrorJson(filePath, error));
+      } else {
+        if (!error.empty())
+          fileOutput << "Failed: " << error << "\n";
+        lock_guard<mutex> lock(outputMutex);
+        cout << "== " << filePath << "\n" << fileOutput.str();
+      }
+
+      lock_guard<mutex> lock(outstandingMutex);
+      if (--outstanding == 0)
+        allReported.notify_all();
+    };
+    auto submit = [&](const string& filePath) {
+      {
+        lock_guard<mutex> lock(outstandingMutex);
+        outstanding++;
+      }
+      try {
+        submitAttempt(filePath, 0);
+      } catch (...) {
+        lock_guard<mutex> lock(outstandingMutex);
+        outstanding--;
+        throw;
+      }
+    };
+    auto onDirectoryError = [&](const string& failedDirectory, const string& error) {
+      failedDirectories++;
+      ReportDirectoryError(failedDirectory, error, action.format, ndjson, outputMutex);
+    };
+
+    // Retries and deferrals of the files already submitted reach pool and process through the scheduler, so those
+    // are only destroyed once every file is reported, even when the enumeration fails
+    exception_ptr enumerationError;
+    try {
+      if (!directory.empty())
+        EnumerateDirectory(directory, submit, onDirectoryError);
+      if (!fileList.empty())
+        EnumerateFileList(fileList, submit);
+    } catch (...) {
+      enumerationError = std::current_exception();
+    }
+    {
+      unique_lock<mutex> lock(outstandingMutex);
+      allReported.wait(lock, [&] { return outstanding == 0; });
+    }
+    // The scheduler task that resubmitted the last file may still be returning from the pool
+    if (retryScheduler)
+      retryScheduler->WaitIdle();
+    if (enumerationError) {
+      ndjson.Flush();
+      std::rethrow_exception(enumerationError);
+    }
+  }
+  ndjson.Flush();
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const size_t total = succeeded + failed;
+  // Keep stdout a pure record stream in ndjson mode
+  ostream& summary = action.format == OutputFormat::Ndjson ? std::cerr : cout;
+  summary << "Processed " << total << " files (" << succeeded << " succeeded, " << failed << " failed) in "
+      << seconds << "s using " << workerCount << " workers";
+  if (seconds > 0)
+    summary << ", " << total / seconds << " files/sec";
+  summary << endl;
+  if (failedDirectories > 0)
+    summary << "Skipped " << failedDirectories << " directories that could not be listed" << endl;
+  if (retryScheduler) {
+    const auto retryStats = retryScheduler->GetStats();
+    summary << "Retries: " << retryStats.retries << " retried, " << retryStats.deferrals << " deferred by an open circuit, "
+        << retryStats.exhausted << " gave up, " << retryStats.breakerTrips << " circuit trips" << endl;
+  }
+}
+
+// Continuation-passing twin of RunFileAction. Each step is started from the SDK callback of the previous one, so
+// no thread is parked on a future while the SDK loads policy, acquires licenses or writes the output file.
+void RunFileActionAsync(
+    const shared_ptr<FileEngine>& fileEngine,
+    const string& filePath,
+    const FileAction& action,
+    const Completion<string>& onComplete) {
+  sample::file::CreateFileHandlerAsync(fileEngine, filePath, action.contentState, action.useMappedStream,
+      [fileEngine, filePath, action, onComplete](const shared_ptr<FileHandler>& fileHandler, const exception_ptr& error) {
+    if (error) {
+      onComplete(string(), error);
+      return;
+    }
+
+    auto out = make_shared<ostringstream>();
+    bool commitNeeded = false;
+    bool notifyAudit = false;
+    try {
+      commitNeeded = PrepareFileAction(fileHandler, filePath, action, *out, notifyAudit);
+    } catch (...) {
+      onComplete(string(), std::current_exception());
+      return;
+    }
+
+    if (!commitNeeded) {
+      onComplete(out->str(), nullptr);
+      return;
+    }
+
+    const string outputFilePath = CreateOutput(fileHandler.get());
+    sample::file::CommitAsync(fileHandler, outputFilePath,
+        [fileHandler, outputFilePath, notifyAudit, action, out, onComplete](bool committed, const exception_ptr& error) {
+      if (error) {
+        onComplete(string(), error);
+        return;
+      }
+      try {
+        ReportCommit(fileHandler, outputFilePath, committed, notifyAudit, action.auditBatcher.get(), *out);
+      } catch (...) {
+        onComplete(string(), std::current_exception());
+        return;
+      }
+      onComplete(out->str(), nullptr);
+    });
+  });
+}
+
+// Same sweep as RunBatch, but driven by SDK callbacks: up to maxInFlight files are being processed at once while
+// only the enumerating thread ever waits, and only for a free slot.
+void RunBatchAsync(
+    const shared_ptr<FileEngine>& fileEngine,
+    const string& directory,
+    const string& fileList,
+    const FileAction& action,
+    size_t maxInFlight) {
+  mutex stateMutex;
+  condition_variable slotReleased;
+  size_t inFlight = 0;
+  size_t succeeded = 0;
+  size_t failed = 0;
+  atomic<size_t> failedDirectories(0);
+  const auto start = std::chrono::steady_clock::now();
+  NdjsonWriter ndjson(stdout);
+
+  auto submit = [&](const string& filePath) {
+    {
+      unique_lock<mutex> lock(stateMutex);
+      slotReleased.wait(lock, [&] { return inFlight < maxInFlight; });
+      inFlight++;
+    }
+
+    RunFileActionAsync(fileEngine, filePath, action, [&, filePath](const string& output, const exception_ptr& error) {
+      string message;
+      if (error) {
+        try {
+          std::rethrow_exception(error);
+        } catch (const std::exception& ex) {
+          message = ex.what();
+        } catch (...) {
+          message = "unknown error";
+        }
+      }
+
+      if (action.format == OutputFormat::Ndjson)
+        ndjson.Write(error ? GetErrorJson(filePath, message) : output);
+
+      lock_guard<mutex> lock(stateMutex);
+      if (action.format != OutputFormat::Ndjson)
+        cout << "== " << filePath << "\n" << (error ? "Failed: " + message + "\n" : output);
+      if (error)
+        failed++;
+      else
+        succeeded++;
+      inFlight--;
+      slotReleased.notify_all();
+    });
+  };
+
+  auto onDirectoryError = [&](const string& failedDirectory, const string& error) {
+    failedDirectories++;
+    ReportDirectoryError(failedDirectory, error, action.format, ndjson, stateMutex);
+  };
+
+  // The callbacks of files in flight use this frame, so it is only left once they have all completed, even when
+  // the enumeration fails
+  exception_ptr enumerationError;
+  try {
+    if (!directory.empty())
+      EnumerateDirectory(directory, submit, onDirectoryError);
+    if (!fileList.empty())
+      EnumerateFileList(fileList, submit);
+  } catch (...) {
+    enumerationError = std::current_exception();
+  }
+
+  {
+    unique_lock<mutex> lock(stateMutex);
+    slotReleased.wait(lock, [&] { return inFlight == 0; });
+  }
+  ndjson.Flush();
+  if (enumerationError)
+    std::rethrow_exception(enumerationError);
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const size_t total = succeeded + failed;
+  ostream& summary = action.format == OutputFormat::Ndjson ? std::cerr : cout;
+  summary << "Processed " << total << " files (" << succeeded << " succeeded, " << failed << " failed) in "
+      << seconds << "s with up to " << maxInFlight << " in flight";
+  if (seconds > 0)
+    summary << ", " << total / seconds << " files/sec";
+  summary << endl;
+  if (failedDirectories > 0)
+    summary << "Skipped " << failedDirectories << " directories that could not be listed" << endl;
+}
+
+void ReportStage(const string& name, const sample::file::PipelineStageStats& stage, ostream& out) {
+  out << "  " << name << ": " << stage.completed << " files, " << static_cast<int>(stage.utilization * 100 + 0.5)
+      << "% busy, at most " << stage.maxActive << " at once" << endl;
+}
+
+// Same sweep as RunBatch, split into stages that overlap across files: while one file is being opened, the previous
+// one has its changes applied and the one before that is committed. Each stage holds at most stageCapacity files.
+void RunBatchPipelined(
+    const shared_ptr<FileEngine>& fileEngine,
+    const string& directory,
+    const string& fileList,
+    const FileAction& action,
+    size_t stageCapacity) {
+  struct FileState {
+    ostringstream out;
+    bool notifyAudit = false;
+  };
+
+  mutex outputMutex;
+  size_t succeeded = 0;
+  size_t failed = 0;
+  size_t failedDirectories = 0; // Only the enumerating thread counts these
+  NdjsonWriter ndjson(stdout);
+  sample::file::CommitPipelineStats stats;
+
+  {
+    sample::file::CommitPipeline pipeline(fileEngine, action.contentState, action.useMappedStream,
+        [&action](sample::file::CommitPipeline::Item& item) {
+      auto state = make_shared<FileState>();
+      item.context = state;
+      if (PrepareFileAction(item.fileHandler, item.filePath, action, state->out, state->notifyAudit))
+        item.outputFilePath = CreateOutput(item.fileHandler.get());
+    },
+        [&](sample::file::CommitPipeline::Item& item, bool committed, const exception_ptr& error) {
+      auto state = std::static_pointer_cast<FileState>(item.context);
+      string message;
+      try {
+        if (error)
+          std::rethrow_exception(error);
+        if (!item.outputFilePath.empty())
+          ReportCommit(item.fileHandler, item.outputFilePath, committed, state->notifyAudit, action.auditBatcher.get(),
+              state->out);
+      } catch (const std::exception& ex) {
+        message = ex.what();
+      } catch (...) {
+        message = "unknown error";
+      }
+
+      const string output = state ? state->out.str() : string();
+      if (action.format == OutputFormat::Ndjson)
+        ndjson.Write(message.empty() ? output : GetErrorJson(item.filePath, message));
+
+      lock_guard<mutex> lock(outputMutex);
+      if (action.format != OutputFormat::Ndjson)
+        cout << "== " << item.filePath << "\n" << (message.empty() ? output : "Failed: " + message + "\n");
+      if (message.empty())
+        succeeded++;
+      else
+        failed++;
+    },
+        stageCapacity);
+
+    auto submit = [&pipeline](const string& filePath) { pipeline.Submit(filePath); };
+    auto onDirectoryError = [&](const string& failedDirectory, const string& error) {
+      failedDirectories++;
+      ReportDirectoryError(failedDirectory, error, action.format, ndjson, outputMutex);
+    };
+    if (!directory.empty())
+      EnumerateDirectory(directory, submit, onDirectoryError);
+    if (!fileList.empty())
+      EnumerateFileList(fileList, submit);
+    pipeline.Drain();
+    stats = pipeline.GetStats();
+  }
+  ndjson.Flush();
+
+  const double seconds = stats.wallMs / 1000;
+  const size_t total = succeeded + failed;
+  ostream& summary = action.format == OutputFormat::Ndjson ? std::cerr : cout;
+  summary << "Processed " << total << " files (" << succeeded << " succeeded, " << failed << " failed) in "
+      << seconds << "s with up to " << stageCapacity << " files per stage";
+  if (seconds > 0)
+    summary << ", " << total / seconds << " files/sec";
+  summary << endl;
+  if (failedDirectories > 0)
+    summary << "Skipped " << failedDirectories << " directories that could not be listed" << endl;
+  ReportStage("open", stats.open, summary);
+  ReportStage("apply", stats.apply, summary);
+  ReportStage("commit", stats.commit, summary);
+}
+
+// Sorts every file under directory into protected and unprotected without a profile, engine or any network call.
+// Only the bytes IsProtected looks at are read from the file, so large files cost little more than small. Directories
+// that cannot be listed are reported with the files that failed.
+void RunTriage(const string& directory, size_t threadCount) {
+  mutex resultMutex;
+  vector<string> protectedFiles;
+  vector<string> unprotectedFiles;
+  vector<pair<string, string>> failedFiles;
+  const auto start = std::chrono::steady_clock::now();
+
+  EnumerateDirectoryParallel(directory, threadCount, [&](const string& filePath) {
+    bool isProtected = false;
+    string error;
+    try {
+      auto inputStream = make_shared<MappedFileStream>(filePath);
+      isProtected = FileHandler::IsProtected(inputStream, filePath);
+    } catch (const std::exception& ex) {
+      error = ex.what();
+    }
+
+    lock_guard<mutex> lock(resultMutex);
+    if (!error.empty())
+      failedFiles.push_back(pair<string, string>(filePath, error));
+    else if (isProtected)
+      protectedFiles.push_back(filePath);
+    else
+      unprotectedFiles.push_back(filePath);
+  }, [&](const string& failedDirectory, const string& error) {
+    lock_guard<mutex> lock(resultMutex);
+    failedFiles.push_back(pair<string, string>(failedDirectory, error));
+  });
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // Threads finish in any order, sort so that runs over the same tree can be diffed
+  std::sort(protectedFiles.begin(), protectedFiles.end());
+  std::sort(unprotectedFiles.begin(), unprotectedFiles.end());
+  std::sort(failedFiles.begin(), failedFiles.end());
+
+  string output;
+  output += "Protected files:\n";
+  for (const auto& filePath : protectedFiles)
+    output += "  " + filePath + "\n";
+  output += "Unprotected files:\n";
+  for (const auto& filePath : unprotectedFiles)
+    output += "  " + filePath + "\n";
+  if (!failedFiles.empty()) {
+    output += "Failed files:\n";
+    for (const auto& failed : failedFiles)
+      output += "  " + failed.first + ": " + failed.second + "\n";
+  }
+  cout << output;
+
+  const size_t total = protectedFiles.size() + unprotectedFiles.size() + failedFiles.size();
+  cout << "Triaged " << total << " files: " << protectedFiles.size() << " protected, " << unprotectedFiles.size()
+      << " unprotected, " << failedFiles.size() << " failed in " << seconds << "s using " << threadCount << " threads";
+  if (seconds > 0)
+    cout << ", " << total / seconds << " files/sec";
+  cout << endl;
+}
+
 string GetWorkingDirectory(int argc, char* argv[]) {
   string fileSamplePath;
   size_t position;
@@ -429,8 +1309,10 @@ int main_impl(int argc, char* argv[]) {
     options.add_options()
       // Action choice
       ("f,file", "Path to the file to work on.", cxxopts::value<string>(), "File path")
+      ("dir", "Path to a directory to work on. All files in the directory tree are processed.", cxxopts::value<string>())
+      ("filelist", "Path to a text file listing the files to work on, one path per line.", cxxopts::value<string>())
       ("g,getfilestatus", "Show the labels and protection that applies on the file.")
-      ("s,setlabel", "Set a label with <labelId>. If downgrading label - will apply "
+      ("s,setlabel", "Set a label with <labelId>, label name or Parent\\Label path. If downgrading label - will apply "
         "<justification message>, if needed and specified.", cxxopts::value<string>())
       ("d,delete", "Delete the current label from the file with <justification message>, if needed and specified.")
       ("p,protect", "Protect with custom permissions protection to comma-separated user list."
@@ -439,6 +1321,7 @@ int main_impl(int argc, char* argv[]) {
       ("templateid", "Protect using Template ID", cxxopts::value<string>())
       ("l,listlabels", "Show all available labels with their ID values.")
       ("u,unprotect", "Remove protection from the given file.")
+      ("triage", "List which files under <dir> are protected. Needs no authentication and makes no network calls.", cxxopts::value<string>())
       
       // Action-dependent options
       ("standard", "The label will be standard label adn will override standard label only.", cxxopts::value<bool>())
@@ -456,11 +1339,33 @@ int main_impl(int argc, char* argv[]) {
       
       // Other options
       ("contentState", "(Optional) Set contentState of content. ['motion'|'use'|'rest'] (Default='rest')", cxxopts::value<string>())
+      ("mmap", "(Optional) Read input files straight from the page cache instead of through a buffered std::istream. Files truncated during the run read short.")
+      ("classify", "(Optional) With getfilestatus, report credit card numbers, IBANs and SSNs in plain-text content. With --format ndjson they are listed under sensitiveInfo.")
+      ("format", "(Optional) Output format of getfilestatus. ['text'|'ndjson'] (Default='text')", cxxopts::value<string>())
       ("policy", "Set path for local policy file.", cxxopts::value<string>())
       ("exportpolicy", "Set path to export downloaded policy to.", cxxopts::value<string>())
+      ("policysnapshot", "(Optional) With --listlabels and --policy, list labels from a compiled snapshot at <path>, "
+        "recompiled only when the policy changes.", cxxopts::value<string>())
       ("extendedkey", "Set an extended property key.", cxxopts::value<string>())
       ("extendedvalue", "Set the extended property value.", cxxopts::value<string>())
       ("locale", "Set the locale/language (default 'en-US')", cxxopts::value<string>())
+      ("storage", "(Optional) Persist profile state under <path> and reuse the engine on later runs.", cxxopts::value<string>())
+#ifndef _WIN32
+      ("httpconnections", "(Optional) Send SDK HTTP requests over pooled keep-alive connections, at most <n> per host.", cxxopts::value<int>())
+      ("recordhttp", "(Optional) Record every SDK HTTP request and response to <path> for --replayhttp.", cxxopts::value<string>())
+      ("sharedtokencache", "(Optional) Share access tokens with other processes on this machine through the shared memory "
+        "segment <name>, e.g. /mip_sample_tokens. Needs XDG_RUNTIME_DIR for its lock file.", cxxopts::value<string>())
+#endif // _WIN32
+      ("replayhttp", "(Optional) Answer SDK HTTP requests from a recording made with --recordhttp instead of the network.", cxxopts::value<string>())
+      ("replaylatency", "(Optional) Milliseconds added to every response served by --replayhttp (Default=0)", cxxopts::value<int>())
+      ("logfile", "(Optional) Write SDK logs to <path> from a background thread instead of the SDK's own logger.", cxxopts::value<string>())
+      ("loglevel", "(Optional) Minimum level written with --logfile. ['trace'|'info'|'warning'|'error'] (Default='info')", cxxopts::value<string>())
+      ("workers", "(Optional) Number of files processed in parallel with --dir, --filelist or --triage (Default=number of cores)", cxxopts::value<int>())
+      ("queuedepth", "(Optional) Number of files queued ahead of the workers with --dir or --filelist (Default=2*workers)", cxxopts::value<int>())
+      ("inflight", "(Optional) Drive --dir or --filelist from SDK callbacks with up to <n> files in flight instead of worker threads.", cxxopts::value<int>())
+      ("pipeline", "(Optional) Run --dir or --filelist as overlapping open, apply and commit stages of up to <n> files each.", cxxopts::value<int>())
+      ("retries", "(Optional) Attempts per file for transient network errors with --dir or --filelist, with backoff and a circuit breaker (Default=4, 1 disables retries)", cxxopts::value<int>())
+      ("auditbatch", "(Optional) With --dir or --filelist, send audit events from a background thread in batches of up to <n>.", cxxopts::value<int>())
       ("h,help", "Print help and exit.")
       ("version", "Display version information.");
 
@@ -479,6 +1384,29 @@ int main_impl(int argc, char* argv[]) {
       return 0;
     }
 
+    // triage only reads file headers, so it runs before any auth, profile or engine setup
+    if (options.count("triage")) {
+      size_t threadCount = std::thread::hardware_concurrency();
+      if (options.count("workers") && options["workers"].as<int>() > 0)
+        threadCount = static_cast<size_t>(options["workers"].as<int>());
+      if (threadCount == 0)
+        threadCount = 1;
+      RunTriage(options["triage"].as<string>(), threadCount);
+      return 0;
+    }
+
+    // --pipeline, --inflight and the worker pool are different ways to run a batch, only one of them can apply
+    if (options.count("pipeline") && options.count("inflight")) {
+      cout << "ERROR: --pipeline and --inflight cannot be combined" << endl;
+      return -1;
+    }
+    if ((options.count("pipeline") || options.count("inflight")) &&
+        (options.count("workers") || options.count("queuedepth") || options.count("retries"))) {
+      cout << "ERROR: --workers, --queuedepth and --retries only apply to the worker pool, not to --pipeline or --inflight"
+          << endl;
+      return -1;
+    }
+
     string locale = "en-US";
     if (options.count("locale"))
       locale = options["locale"].as<string>();
@@ -501,6 +1429,27 @@ int main_impl(int argc, char* argv[]) {
       policyPath = exportPolicyPath;
     }
 
+    OutputFormat format = OutputFormat::Text;
+    if (options.count("format")) {
+      string formatName = options["format"].as<string>();
+      if (formatName == "ndjson") {
+        format = OutputFormat::Ndjson;
+      } else if (formatName != "text") {
+        cout << "ERROR: Invalid <format> value. Choose 'text' or 'ndjson'" << endl;
+        return -1;
+      }
+    }
+    // Keep stdout a pure record stream in ndjson mode, everything else the sample reports goes to stderr then
+    ostream& status = format == OutputFormat::Ndjson ? std::cerr : cout;
+
+    if (options.count("listlabels") && options.count("policysnapshot") && !policyPath.empty() && !exportPolicy) {
+      ListLabelsFromSnapshot(policyPath, locale, options["policysnapshot"].as<string>());
+      return 0;
+    }
+
+    if (!policyPath.empty() && !exportPolicy)
+      status << "Using policy from file: " << policyPath << endl;
+
     const auto protectionOnly = options.count("unprotect") || options.count("protect") || options.count("templateid");
     const auto hasAuthentication = (!username.empty() && !password.empty()) || (!protectionToken.empty() && (protectionOnly || !sccToken.empty()));
     
@@ -519,10 +1468,94 @@ int main_impl(int argc, char* argv[]) {
       return 0;
     }
 
-    auto authDelegate = make_shared<AuthDelegateImpl>(password, clientId, sccToken, protectionToken, fileSampleWorkingDirectory);
+    shared_ptr<sample::auth::SharedTokenCache> sharedTokenCache;
+#ifndef _WIN32
+    if (options.count("sharedtokencache"))
+      sharedTokenCache = make_shared<sample::auth::SharedTokenCache>(options["sharedtokencache"].as<string>());
+#endif // _WIN32
+    auto authDelegate = make_shared<AuthDelegateImpl>(
+        password, clientId, sccToken, protectionToken, fileSampleWorkingDirectory, sharedTokenCache);
     auto consentDelegate = make_shared<ConsentDelegateImpl>();
-    auto profile = CreateProfile(authDelegate, consentDelegate);
-    auto fileEngine = GetFileEngine(profile, username, protectionBaseUrl, policyPath, exportPolicy, protectionOnly, locale);
+
+    string storagePath;
+    if (options.count("storage"))
+      storagePath = options["storage"].as<string>();
+
+    const auto startupBegin = std::chrono::steady_clock::now();
+    shared_ptr<mip::HttpDelegate> httpDelegate;
+#ifndef _WIN32
+    shared_ptr<PooledHttpDelegate> pooledHttpDelegate;
+    if (options.count("httpconnections") || options.count("recordhttp")) {
+      size_t maxConnectionsPerHost = 8;
+      if (options.count("httpconnections"))
+        maxConnectionsPerHost = static_cast<size_t>(options["httpconnections"].as<int>());
+      pooledHttpDelegate = make_shared<PooledHttpDelegate>(maxConnectionsPerHost);
+      httpDelegate = pooledHttpDelegate;
+    }
+    if (options.count("recordhttp"))
+      httpDelegate = make_shared<RecordingHttpDelegate>(pooledHttpDelegate, options["recordhttp"].as<string>());
+#endif // _WIN32
+    if (options.count("replayhttp")) {
+      if (httpDelegate) {
+        cout << "ERROR: --replayhttp cannot be combined with --httpconnections or --recordhttp" << endl;
+        return -1;
+      }
+      int latencyMs = 0;
+      if (options.count("replaylatency"))
+        latencyMs = options["replaylatency"].as<int>();
+      auto replayHttpDelegate = make_shared<ReplayHttpDelegate>(
+          options["replayhttp"].as<string>(), std::chrono::milliseconds(latencyMs > 0 ? latencyMs : 0));
+      status << "Replaying " << replayHttpDelegate->GetExchangeCount() << " recorded HTTP exchanges" << endl;
+      httpDelegate = replayHttpDelegate;
+    }
+
+    shared_ptr<AsyncRingLogger> logger;
+    if (options.count("logfile")) {
+      mip::LogLevel logLevel = mip::LogLevel::Info;
+      if (options.count("loglevel")) {
+        string level = options["loglevel"].as<string>();
+        if (level == "trace") {
+          logLevel = mip::LogLevel::Trace;
+        } else if (level == "info") {
+          logLevel = mip::LogLevel::Info;
+        } else if (level == "warning") {
+          logLevel = mip::LogLevel::Warning;
+        } else if (level == "error") {
+          logLevel = mip::LogLevel::Error;
+        } else {
+          cout << "ERROR: Invalid <loglevel> value. Choose 'trace', 'info', 'warning', or 'error'" << endl;
+          return -1;
+        }
+      }
+      logger = make_shared<AsyncRingLogger>(options["logfile"].as<string>(), logLevel);
+    }
+
+    // Label lookups go through an index built once per engine and swapped for a new one when the engine's policy changes
+    auto labelIndexCache = make_shared<LabelIndexCache>();
+    auto watchedLabel = make_shared<WatchedLabel>();
+    // Runs on an SDK thread while files may be written to stdout, so it reports on stderr
+    labelIndexCache->AddListener([watchedLabel](const string& engineId, const sample::file::LabelChangeSet& changes) {
+      std::cerr << "Policy changed for engine " << engineId << ": " << changes.added.size() << " labels added, "
+          << changes.removed.size() << " removed, " << changes.changed.size() << " changed" << endl;
+      lock_guard<mutex> lock(watchedLabel->labelIdMutex);
+      if (!watchedLabel->labelId.empty() && changes.Affects(watchedLabel->labelId) && !watchedLabel->invalidated.exchange(true))
+        std::cerr << "Label " << watchedLabel->labelId << " was changed or removed, remaining files are not labeled" << endl;
+    });
+    auto profile = CreateProfile(authDelegate, consentDelegate, storagePath, httpDelegate, logger,
+        [labelIndexCache](const string& engineId) { labelIndexCache->OnPolicyChanged(engineId); });
+    const auto profileLoaded = std::chrono::steady_clock::now();
+    bool warmStart = false;
+    auto fileEngine = GetFileEngine(profile, username, protectionBaseUrl, policyPath, exportPolicy, protectionOnly, locale,
+        storagePath, warmStart);
+    const auto engineLoaded = std::chrono::steady_clock::now();
+
+    if (!storagePath.empty()) {
+      using std::chrono::duration_cast;
+      using std::chrono::milliseconds;
+      status << "Startup (" << (warmStart ? "warm" : "cold") << "): profile "
+          << duration_cast<milliseconds>(profileLoaded - startupBegin).count() << " ms, engine "
+          << duration_cast<milliseconds>(engineLoaded - profileLoaded).count() << " ms" << endl;
+    }
     
     if (exportPolicy) {
       cout << "Policy file exported to: " << exportPolicyPath << endl;
@@ -531,8 +1564,7 @@ int main_impl(int argc, char* argv[]) {
 
     // listlabels
     if (options.count("listlabels")) {
-      const vector<shared_ptr<mip::Label>> labels(fileEngine->ListSensitivityLabels());
-      ListLabels(labels);
+      ListLabels(*labelIndexCache->Get(fileEngine)->Get());
       return 0;
     }
 
@@ -542,106 +1574,156 @@ int main_impl(int argc, char* argv[]) {
       filePath = options["file"].as<string>();
     }
 
-    if (filePath.empty()) {
+    string directory;
+    if (options.count("dir")) {
+      directory = options["dir"].as<string>();
+    }
+
+    string fileList;
+    if (options.count("filelist")) {
+      fileList = options["filelist"].as<string>();
+    }
+
+    if (filePath.empty() && directory.empty() && fileList.empty()) {
       cout << options.help({ "" }) << endl;
       return 0;
     }
 
-    ContentState contentState = ContentState::REST;
+    FileAction action;
     if (options.count("contentState")) {
       string state = options["contentState"].as<string>();
       if (state == "motion") {
-        contentState = ContentState::MOTION;
+        action.contentState = ContentState::MOTION;
       } else if (state == "use") {
-        contentState = ContentState::USE;
+        action.contentState = ContentState::USE;
       } else if (state == "rest") {
-        contentState = ContentState::REST;
+        action.contentState = ContentState::REST;
       } else {
         cout << "ERROR: Invalid <contentState> value. Choose 'motion', 'use', or 'rest'" << endl;
         return -1;
       }
     }
-    // All the rest of commands are file based. We need file handler.
-    auto fileHandler = GetFileHandler(fileEngine, filePath, contentState);
 
-    // getlabel
-    if (options.count("getfilestatus")) {
-      GetLabel(fileHandler);
-      return 0;
-    }
+    action.useMappedStream = options.count("mmap") > 0;
+    if (options.count("classify"))
+      action.classifier = make_shared<ContentClassifier>();
+
+    action.format = format;
 
-    auto method = options["auto"].as<bool>() ? AssignmentMethod::AUTO : options["privileged"].as<bool>() ?  AssignmentMethod::PRIVILEGED :
+    action.method = options["auto"].as<bool>() ? AssignmentMethod::AUTO : options["privileged"].as<bool>() ?  AssignmentMethod::PRIVILEGED :
       AssignmentMethod::STANDARD;
 
-    // setlabel
-    if (options.count("setlabel")) {
-      
-      //Parse set label options
-      const auto labelId = options["setlabel"].as<string>();
-      string justificationMessage;
-      string extendedKey;
-      string extendedValue;
-      vector<pair<string, string>> extendedProperties;
-
-      if (options.count("justification")) {
-        justificationMessage = options["justification"].as<string>();
+    if (options.count("justification")) {
+      action.justificationMessage = options["justification"].as<string>();
+    }
+
+    if (options.count("getfilestatus")) {
+      // getlabel
+      action.type = FileActionType::GetStatus;
+    } else if (options.count("setlabel")) {
+      // setlabel
+      action.type = FileActionType::SetLabel;
+      // Accept a label name as well as an ID, and reject unknown labels before any file is opened
+      action.labelId = labelIndexCache->Get(fileEngine)->Get()->Resolve(options["setlabel"].as<string>()).label->GetId();
+      {
+        lock_guard<mutex> lock(watchedLabel->labelIdMutex);
+        watchedLabel->labelId = action.labelId;
       }
+      action.watchedLabel = watchedLabel;
 
       if (options.count("extendedkey")) {
         if (options.count("extendedvalue")) {
-          extendedKey = options["extendedkey"].as<string>();
-          extendedValue = options["extendedvalue"].as<string>();
-          pair<string, string> extendedProperty = pair<string, string>(extendedKey, extendedValue);
-          extendedProperties.push_back(extendedProperty);
+          action.extendedProperties.push_back(pair<string, string>(
+              options["extendedkey"].as<string>(), options["extendedvalue"].as<string>()));
         } else {
           throw cxxopts::OptionException("Missing extendedvalue.");
         }
       }
-      
-      // Set the label on the file
-      SetLabel(fileHandler, labelId, method, justificationMessage, extendedProperties);
-      return 0;
+    } else if (options.count("delete")) {
+      // delete
+      action.type = FileActionType::DeleteLabel;
+    } else if (options.count("unprotect")) {
+      // unprotect
+      action.type = FileActionType::Unprotect;
+    } else if (options.count("protect")) {
+      // protect
+      // If protect option was given but no rights were provided throw exception
+      if (!options.count("rights"))
+        throw cxxopts::OptionException("Missing rights for protection. use <rights>.");
+
+      action.type = FileActionType::Protect;
+      action.users = options["protect"].as<string>();
+      action.rights = options["rights"].as<string>();
+    } else if (options.count("templateid")) {
+      //protect using template ID
+      action.type = FileActionType::ProtectWithTemplate;
+      action.templateId = options["templateid"].as<string>();
     }
+    // default when there is a only file path - Show labels
 
-    // delete
-    if (options.count("delete")) {
-
-      string justificationMessage;
-      if (options.count("justification")) {
-        justificationMessage = options["justification"].as<string>();
-      }
-
-      // SetLabel without labelId delete the label
-      SetLabel(fileHandler, "", method, justificationMessage, vector<pair<string, string>>());
-      return 0;
+    if (action.format == OutputFormat::Ndjson && action.type != FileActionType::GetStatus) {
+      cout << "ERROR: --format ndjson is only supported with getfilestatus" << endl;
+      return -1;
     }
 
-    // unprotect
-    if (options.count("unprotect")) {
-      Unprotect(fileHandler, filePath);
-      return 0;
+    if ((!directory.empty() || !fileList.empty()) && options.count("auditbatch") && options["auditbatch"].as<int>() > 0)
+      action.auditBatcher = make_shared<AuditBatcher>(static_cast<size_t>(options["auditbatch"].as<int>()));
+
+    if ((!directory.empty() || !fileList.empty()) && options.count("pipeline") && options["pipeline"].as<int>() > 0) {
+      RunBatchPipelined(fileEngine, directory, fileList, action, static_cast<size_t>(options["pipeline"].as<int>()));
+    } else if ((!directory.empty() || !fileList.empty()) && options.count("inflight") && options["inflight"].as<int>() > 0) {
+      RunBatchAsync(fileEngine, directory, fileList, action, static_cast<size_t>(options["inflight"].as<int>()));
+    } else if (!directory.empty() || !fileList.empty()) {
+      size_t workerCount = std::thread::hardware_concurrency();
+      if (options.count("workers") && options["workers"].as<int>() > 0)
+        workerCount = static_cast<size_t>(options["workers"].as<int>());
+      if (workerCount == 0)
+        workerCount = 1;
+
+      size_t queueDepth = workerCount * 2;
+      if (options.count("queuedepth") && options["queuedepth"].as<int>() > 0)
+        queueDepth = static_cast<size_t>(options["queuedepth"].as<int>());
+
+      // Transient errors are retried unless --retries 1 asks for a single attempt per file
+      std::unique_ptr<RetryScheduler> retryScheduler;
+      RetryPolicy retryPolicy;
+      if (options.count("retries"))
+        retryPolicy.maxAttempts = options["retries"].as<int>();
+      if (retryPolicy.maxAttempts > 1)
+        retryScheduler.reset(new RetryScheduler(retryPolicy));
+
+      RunBatch(fileEngine, directory, fileList, action, workerCount, queueDepth, retryScheduler.get());
+    } else if (action.format == OutputFormat::Ndjson) {
+      ostringstream record;
+      RunFileAction(fileEngine, filePath, action, record);
+      NdjsonWriter(stdout).Write(record.str());
+    } else {
+      RunFileAction(fileEngine, filePath, action, cout);
     }
 
-    // protect
-    if (options.count("protect")) {
-      if (options.count("rights")) {
-        ProtectWithCustomPermissions(fileHandler, options["protect"].as<string>(),
-          options["rights"].as<string>());
-        return 0;
-      }
-
-      // If protect option was given but no rights were provided throw exception
-      throw cxxopts::OptionException("Missing rights for protection. use <rights>.");
+    if (action.auditBatcher) {
+      action.auditBatcher->Flush();
+      const auto auditStats = action.auditBatcher->GetStats();
+      status << "Audit: " << auditStats.submitted << " events submitted in " << auditStats.batches << " batches, "
+          << auditStats.failed << " failed, max queue depth " << auditStats.maxPendingSeen << endl;
     }
 
-    //protect using template ID
-    if (options.count("templateid")) {
-      ProtectWithPermissions(fileHandler, ProtectionDescriptorBuilder::CreateFromTemplate(options["templateid"].as<string>()));
-      return 0;
+#ifndef _WIN32
+    if (pooledHttpDelegate) {
+      status << "HTTP: " << pooledHttpDelegate->GetLatencySummary() << ", connections opened: "
+          << pooledHttpDelegate->GetConnectionCount() << endl;
     }
+    if (sharedTokenCache) {
+      status << "Shared token cache: " << sharedTokenCache->GetHitCount() << " hits, "
+          << sharedTokenCache->GetFetchCount() << " tokens fetched by this process" << endl;
+    }
+#endif // _WIN32
 
-    // default when there is a only file path - Show labels
-    GetLabel(fileHandler);
+    if (logger) {
+      logger->Flush();
+      if (logger->GetDroppedCount() > 0)
+        status << "Log records dropped because the log buffer was full: " << logger->GetDroppedCount() << endl;
+    }
 
   } catch (const cxxopts::OptionException& ex) {
     cout << "Error parsing options: " << ex.what() << endl;
@@ -0,0 +1,452 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "policy_snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "mapped_file_stream.h"
+#include "string_utils.h"
+
+using sample::utils::MappedFileStream;
+using std::pair;
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+namespace {
+
+static const char kSnapshotMagic[8] = { 'M', 'I', 'P', 'P', 'S', 'N', 'P', '2' };
+
+// Size and modification time of path. Returns false if the file cannot be examined.
+bool GetFileStamp(const string& path, int64_t& size, int64_t& modified) {
+#ifdef _WIN32
+  struct _stat64 info;
+  if (_wstat64(ConvertStringToWString(path).c_str(), &info) != 0)
+    return false;
+  modified = static_cast<int64_t>(info.st_mtime) * 1000000000;
+#else
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0)
+    return false;
+#ifdef __APPLE__
+  modified = static_cast<int64_t>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+  modified = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif // __APPLE__
+#endif // _WIN32
+  size = static_cast<int64_t>(info.st_size);
+  return true;
+}
+
+string ReadFile(const string& path) {
+  std::ifstream ifs(FILENAME_STRING(path), std::ios::binary);
+  if (ifs.fail())
+    throw runtime_error("Failed to read path: " + path);
+  ifs.seekg(0, std::ios::end);
+  const auto size = ifs.tellg();
+  ifs.seekg(0, std::ios::beg);
+  string content(size > 0 ? static_cast<size_t>(size) : 0, '\0');
+  if (!content.empty() && !ifs.read(&content[0], content.size()))
+    throw runtime_error("Failed to read path: " + path);
+  return content;
+}
+
+string DecodeXmlText(const string& text) {
+  if (text.find('&') == string::npos)
+    return text;
+
+  string decoded;
+  decoded.reserve(text.size());
+  for (size_t i = 0; i < text.size(); i++) {
+    auto end = text[i] == '&' ? text.find(';', i) : string::npos;
+    if (end == string::npos) {
+      decoded += text[i];
+      continue;
+    }
+
+    const string entity = text.substr(i + 1, end - i - 1);
+    if (entity == "amp") decoded += '&';
+    else if (entity == "lt") decoded += '<';
+    else if (entity == "gt") decoded += '>';
+    else if (entity == "quot") decoded += '"';
+    else if (entity == "apos") decoded += '\'';
+    else if (!entity.empty() && entity[0] == '#') {
+      unsigned long code = entity.size() > 1 && (entity[1] == 'x' || entity[1] == 'X') ?
+          strtoul(entity.c_str() + 2, nullptr, 16) : strtoul(entity.c_str() + 1, nullptr, 10);
+      // Encode the code point as UTF-8
+      if (code < 0x80) {
+        decoded += static_cast<char>(code);
+      } else if (code < 0x800) {
+        decoded += static_cast<char>(0xC0 | (code >> 6));
+        decoded += static_cast<char>(0x80 | (code & 0x3F));
+      } else if (code < 0x10000) {
+        decoded += static_cast<char>(0xE0 | (code >> 12));
+        decoded += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        decoded += static_cast<char>(0x80 | (code & 0x3F));
+      } else {
+        decoded += static_cast<char>(0xF0 | (code >> 18));
+        decoded += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        decoded += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        decoded += static_cast<char>(0x80 | (code & 0x3F));
+      }
+    } else {
+      decoded.append(text, i, end - i + 1); // Unknown entity, keep as is
+    }
+    i = end;
+  }
+  return decoded;
+}
+
+// One start or end tag of the document. Only what the policy's label section needs is recognized: no CDATA, no DTD.
+struct XmlTag {
+  string name;
+  vector<pair<string, string>> attributes;
+  bool isEnd = false;
+  bool isSelfClosing = false;
+
+  string GetAttribute(const string& attribute) const {
+    for (const auto& item : attributes) {
+      if (item.first == attribute)
+        return item.second;
+    }
+    return string();
+  }
+};
+
+// Reads the next tag at or after position, leaving position just past it. Returns false at the end of the document.
+bool NextTag(const string& xml, size_t& position, XmlTag& tag) {
+  for (;;) {
+    auto start = xml.find('<', position);
+    if (start == string::npos)
+      return false;
+
+    if (xml.compare(start, 4, "<!--") == 0) {
+      auto end = xml.find("-->", start + 4);
+      if (end == string::npos)
+        return false;
+      position = end + 3;
+      continue;
+    }
+
+    // The tag ends at the first '>' outside a quoted attribute value
+    size_t end = start + 1;
+    char quote = 0;
+    for (; end < xml.size(); end++) {
+      if (quote) {
+        if (xml[end] == quote)
+          quote = 0;
+      } else if (xml[end] == '"' || xml[end] == '\'') {
+        quote = xml[end];
+      } else if (xml[end] == '>') {
+        break;
+      }
+    }
+    if (end >= xml.size())
+      return false;
+    position = end + 1;
+    if (xml[start + 1] == '?' || xml[start + 1] == '!')
+      continue;
+
+    tag = XmlTag();
+    size_t i = start + 1;
+    if (xml[i] == '/') {
+      tag.isEnd = true;
+      i++;
+    }
+    auto nameEnd = xml.find_first_of(" \t\r\n/>", i);
+    tag.name = xml.substr(i, nameEnd - i);
+    tag.isSelfClosing = xml[end - 1] == '/';
+
+    // name="value" pairs up to the end of the tag
+    i = nameEnd;
+    while (i < end) {
+      auto equals = xml.find('=', i);
+      if (equals == string::npos || equals > end)
+        break;
+      auto attributeStart = xml.find_first_not_of(" \t\r\n", i);
+      string attribute = xml.substr(attributeStart, xml.find_last_not_of(" \t\r\n", equals - 1) - attributeStart + 1);
+      auto quote = xml.find_first_of("\"'", equals);
+      if (quote == string::npos || quote > end)
+        break;
+      auto valueEnd = xml.find(xml[quote], quote + 1);
+      if (valueEnd == string::npos || valueEnd > end)
+        break;
+      tag.attributes.push_back(pair<string, string>(attribute, DecodeXmlText(xml.substr(quote + 1, valueEnd - quote - 1))));
+      i = valueEnd + 1;
+    }
+    return true;
+  }
+}
+
+void AppendUInt32(string& out, uint32_t value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void AppendString(string& out, const string& value) {
+  AppendUInt32(out, static_cast<uint32_t>(value.size()));
+  out += value;
+}
+
+// Bounds-checked reader over the mapped snapshot
+class SnapshotReader {
+public:
+  SnapshotReader(const uint8_t* data, int64_t size) : mData(data), mSize(static_cast<size_t>(size)), mPosition(0) { }
+
+  void Read(void* value, size_t size) {
+    if (size > mSize - mPosition)
+      throw runtime_error("Truncated policy snapshot");
+    memcpy(value, mData + mPosition, size);
+    mPosition += size;
+  }
+
+  uint32_t ReadUInt32() {
+    uint32_t value;
+    Read(&value, sizeof(value));
+    return value;
+  }
+
+  string ReadString() {
+    const uint32_t size = ReadUInt32();
+    if (size > mSize - mPosition)
+      throw runtime_error("Truncated policy snapshot");
+    string value(reinterpret_cast<const char*>(mData + mPosition), size);
+    mPosition += size;
+    return value;
+  }
+
+private:
+  const uint8_t* mData;
+  size_t mSize;
+  size_t mPosition;
+};
+
+} // namespace
+
+namespace sample {
+namespace file {
+
+PolicySnapshot PolicySnapshot::Compile(const string& policyXml, const string& locale) {
+  PolicySnapshot snapshot;
+  snapshot.mLocale = locale;
+
+  vector<int32_t> open; // Labels whose end tag has not been seen yet
+  int labelsDepth = 0;
+  size_t position = 0;
+  XmlTag tag;
+  while (NextTag(policyXml, position, tag)) {
+    if (tag.name == "labels") {
+      labelsDepth += tag.isEnd ? -1 : (tag.isSelfClosing ? 0 : 1);
+      if (tag.isEnd && labelsDepth == 0)
+        break; // End of the label section, the rest of the policy is rules
+    } else if (labelsDepth == 0) {
+      continue;
+    } else if (tag.name == "label") {
+      if (tag.isEnd) {
+        if (!open.empty())
+          open.pop_back();
+        continue;
+      }
+      Label label;
+      label.id = tag.GetAttribute("id");
+      label.name = tag.GetAttribute("name");
+      label.parent = open.empty() ? -1 : open.back();
+      snapshot.mLabels.push_back(label);
+      if (!tag.isSelfClosing)
+        open.push_back(static_cast<int32_t>(snapshot.mLabels.size() - 1));
+    } else if (!tag.isEnd && !tag.isSelfClosing && (tag.name == "displayName" || tag.name == "description")) {
+      auto textEnd = policyXml.find('<', position);
+      if (open.empty() || textEnd == string::npos)
+        continue;
+      Label& label = snapshot.mLabels[open.back()];
+      string& field = tag.name == "displayName" ? label.displayName : label.description;
+      // Prefer the requested locale, otherwise keep the first one
+      if (field.empty() || tag.GetAttribute("locale") == locale)
+        field = DecodeXmlText(policyXml.substr(position, textEnd - position));
+    } else if (tag.name == "setting" && !tag.isEnd) {
+      const string key = tag.GetAttribute("key");
+      const string value = tag.GetAttribute("value");
+      if (open.empty()) {
+        snapshot.mSettings.push_back(pair<string, string>(key, value));
+      } else if (key == "order") {
+        snapshot.mLabels[open.back()].order = atoi(value.c_str());
+      } else if (key == "color") {
+        snapshot.mLabels[open.back()].color = value;
+      }
+    }
+  }
+
+  // Emit the tree depth first with siblings in ascending order, keeping document order between equal ones
+  vector<vector<int32_t>> children(snapshot.mLabels.size() + 1); // Last one holds the top-level labels
+  for (size_t i = 0; i < snapshot.mLabels.size(); i++) {
+    const int32_t parent = snapshot.mLabels[i].parent;
+    children[parent < 0 ? snapshot.mLabels.size() : static_cast<size_t>(parent)].push_back(static_cast<int32_t>(i));
+  }
+  for (auto& siblings : children) {
+    std::stable_sort(siblings.begin(), siblings.end(), [&snapshot](int32_t a, int32_t b) {
+      return snapshot.mLabels[a].order < snapshot.mLabels[b].order;
+    });
+  }
+
+  vector<Label> sorted;
+  sorted.reserve(snapshot.mLabels.size());
+  vector<pair<int32_t, int32_t>> pending; // Original index, new index of its parent
+  const auto& roots = children.back();
+  for (auto it = roots.rbegin(); it != roots.rend(); ++it)
+    pending.push_back(pair<int32_t, int32_t>(*it, -1));
+  while (!pending.empty()) {
+    const auto item = pending.back();
+    pending.pop_back();
+    sorted.push_back(snapshot.mLabels[item.first]);
+    sorted.back().parent = item.second;
+    const int32_t index = static_cast<int32_t>(sorted.size() - 1);
+    const auto& siblings = children[item.first];
+    for (auto it = siblings.rbegin(); it != siblings.rend(); ++it)
+      pending.push_back(pair<int32_t, int32_t>(*it, index));
+  }
+  snapshot.mLabels.swap(sorted);
+
+  return snapshot;
+}
+
+PolicySnapshot PolicySnapshot::Load(const string& snapshotPath) {
+  MappedFileStream stream(snapshotPath);
+  SnapshotReader reader(stream.Data(), stream.Size());
+
+  char magic[sizeof(kSnapshotMagic)];
+  reader.Read(magic, sizeof(magic));
+  if (memcmp(magic, kSnapshotMagic, sizeof(magic)) != 0)
+    throw runtime_error("Not a policy snapshot: " + snapshotPath);
+
+  PolicySnapshot snapshot;
+  reader.Read(&snapshot.mSourceSize, sizeof(snapshot.mSourceSize));
+  reader.Read(&snapshot.mSourceModified, sizeof(snapshot.mSourceModified));
+  snapshot.mLocale = reader.ReadString();
+
+  const uint32_t labelCount = reader.ReadUInt32();
+  snapshot.mLabels.resize(labelCount);
+  for (auto& label : snapshot.mLabels) {
+    reader.Read(&label.parent, sizeof(label.parent));
+    reader.Read(&label.order, sizeof(label.order));
+    label.id = reader.ReadString();
+    label.name = reader.ReadString();
+    label.displayName = reader.ReadString();
+    label.description = reader.ReadString();
+    label.color = reader.ReadString();
+  }
+  for (uint32_t i = 0; i < labelCount; i++) {
+    const int32_t parent = snapshot.mLabels[i].parent;
+    if (parent < -1 || parent >= static_cast<int32_t>(i))
+      throw runtime_error("Corrupt policy snapshot: " + snapshotPath);
+  }
+
+  const uint32_t settingCount = reader.ReadUInt32();
+  for (uint32_t i = 0; i < settingCount; i++) {
+    string key = reader.ReadString();
+    snapshot.mSettings.push_back(pair<string, string>(key, reader.ReadString()));
+  }
+  return snapshot;
+}
+
+void PolicySnapshot::Save(const string& snapshotPath) const {
+  string data(kSnapshotMagic, sizeof(kSnapshotMagic));
+  data.append(reinterpret_cast<const char*>(&mSourceSize), sizeof(mSourceSize));
+  data.append(reinterpret_cast<const char*>(&mSourceModified), sizeof(mSourceModified));
+  AppendString(data, mLocale);
+
+  AppendUInt32(data, static_cast<uint32_t>(mLabels.size()));
+  for (const auto& label : mLabels) {
+    data.append(reinterpret_cast<const char*>(&label.parent), sizeof(label.parent));
+    data.append(reinterpret_cast<const char*>(&label.order), sizeof(label.order));
+    AppendString(data, label.id);
+    AppendString(data, label.name);
+    AppendString(data, label.displayName);
+    AppendString(data, label.description);
+    AppendString(data, label.color);
+  }
+
+  AppendUInt32(data, static_cast<uint32_t>(mSettings.size()));
+  for (const auto& setting : mSettings) {
+    AppendString(data, setting.first);
+    AppendString(data, setting.second);
+  }
+
+  // Write next to the target and rename, so a concurrent reader never maps a half-written snapshot
+  const string temporaryPath = snapshotPath + ".tmp";
+  {
+    std::ofstream out(FILENAME_STRING(temporaryPath), std::ios::binary | std::ios::trunc);
+    if (out.fail())
+      throw runtime_error("Failed to write policy snapshot: " + snapshotPath);
+    out.write(data.data(), data.size());
+    if (out.fail())
+      throw runtime_error("Failed to write policy snapshot: " + snapshotPath);
+  }
+#ifdef _WIN32
+  remove(snapshotPath.c_str());
+#endif // _WIN32
+  if (rename(temporaryPath.c_str(), snapshotPath.c_str()) != 0)
+    throw runtime_error("Failed to write policy snapshot: " + snapshotPath);
+}
+
+PolicySnapshot PolicySnapshot::LoadOrCompile(
+    const string& policyPath,
+    const string& locale,
+    const string& snapshotPath,
+    bool& compiled) {
+  compiled = false;
+  int64_t size = 0;
+  int64_t modified = 0;
+  if (!GetFileStamp(policyPath, size, modified))
+    throw runtime_error("Failed to read path: " + policyPath);
+
+  try {
+    PolicySnapshot snapshot = Load(snapshotPath);
+    if (snapshot.mSourceSize == size && snapshot.mSourceModified == modified && snapshot.mLocale == locale)
+      return snapshot;
+  } catch (const std::exception&) {
+    // Missing or unreadable snapshot, compile a new one
+  }
+
+  PolicySnapshot snapshot = Compile(ReadFile(policyPath), locale);
+  // Stamp the snapshot with what was examined before reading, so a policy rewritten meanwhile is compiled again
+  snapshot.mSourceSize = size;
+  snapshot.mSourceModified = modified;
+  snapshot.Save(snapshotPath);
+  compiled = true;
+  return snapshot;
+}
+
+} // namespace file
+} // namespace sample
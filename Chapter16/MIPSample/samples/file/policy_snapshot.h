@@ -0,0 +1,93 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLE_POLICY_SNAPSHOT_H_
+#define SAMPLE_POLICY_SNAPSHOT_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sample {
+namespace file {
+
+// Label tree and label settings of a local policy file, compiled once into a compact binary file that later runs map
+// instead of reading the XML. The snapshot records the size and modification time of the policy file it was compiled
+// from plus the locale, and is recompiled whenever any of them differs, so an up-to-date snapshot is used without
+// reading the policy file at all.
+//
+// The snapshot is a local cache in native byte order, not an interchange format. The SDK itself still gets the XML.
+class PolicySnapshot final {
+public:
+  struct Label {
+    std::string id;
+    std::string name; // What mip::Label::GetName() reports
+    std::string displayName; // For the snapshot's locale, or the first one found
+    std::string description;
+    std::string color;
+    int32_t parent = -1; // Index into GetLabels(), -1 for top-level labels
+    int32_t order = 0; // Position among its siblings
+  };
+
+  // Parses the label section of a policy XML document
+  static PolicySnapshot Compile(const std::string& policyXml, const std::string& locale);
+
+  // Returns the snapshot stored at snapshotPath if it was compiled from the current policyPath for locale. Otherwise
+  // compiles policyPath and rewrites snapshotPath. compiled reports which of the two happened.
+  static PolicySnapshot LoadOrCompile(
+      const std::string& policyPath,
+      const std::string& locale,
+      const std::string& snapshotPath,
+      bool& compiled);
+
+  // Reads a snapshot through a memory mapping. Throws std::runtime_error if the file is not a valid snapshot.
+  static PolicySnapshot Load(const std::string& snapshotPath);
+  void Save(const std::string& snapshotPath) const;
+
+  // Labels depth first with siblings sorted by order, as FileEngine::ListSensitivityLabels returns them, so parents
+  // always come before their children
+  const std::vector<Label>& GetLabels() const { return mLabels; }
+  // Policy-wide label settings, such as defaultLabelId
+  const std::vector<std::pair<std::string, std::string>>& GetSettings() const { return mSettings; }
+
+  int64_t GetSourceSize() const { return mSourceSize; }
+  int64_t GetSourceModified() const { return mSourceModified; } // Nanoseconds since the epoch where available
+  const std::string& GetLocale() const { return mLocale; }
+
+private:
+  int64_t mSourceSize = -1;
+  int64_t mSourceModified = 0;
+  std::string mLocale;
+  std::vector<Label> mLabels;
+  std::vector<std::pair<std::string, std::string>> mSettings;
+};
+
+} // namespace file
+} // namespace sample
+
+#endif // SAMPLE_POLICY_SNAPSHOT_H_
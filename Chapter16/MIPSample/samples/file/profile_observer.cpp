@@ -32,6 +32,8 @@
 using std::promise;
 using std::shared_ptr;
 using std::static_pointer_cast;
+using std::string;
+using std::vector;
 using mip::FileEngine;
 using mip::FileProfile;
 
@@ -45,6 +47,26 @@ void ProfileObserver::OnLoadFailure(const std::exception_ptr& error, const share
   promise->set_exception(error);
  }
 
+void ProfileObserver::OnListEnginesSuccess(const vector<string>& engineIds, const shared_ptr<void>& context) {
+  auto promise = static_pointer_cast<std::promise<vector<string>>>(context);
+  promise->set_value(engineIds);
+}
+
+void ProfileObserver::OnListEnginesFailure(const std::exception_ptr& error, const shared_ptr<void>& context) {
+  auto promise = static_pointer_cast<std::promise<vector<string>>>(context);
+  promise->set_exception(error);
+}
+
+void ProfileObserver::OnUnloadEngineSuccess(const shared_ptr<void>& context) {
+  auto promise = static_pointer_cast<std::promise<void>>(context);
+  promise->set_value();
+}
+
+void ProfileObserver::OnUnloadEngineFailure(const std::exception_ptr& error, const shared_ptr<void>& context) {
+  auto promise = static_pointer_cast<std::promise<void>>(context);
+  promise->set_exception(error);
+}
+
 void ProfileObserver::OnAddEngineSuccess(const shared_ptr<FileEngine>& engine, const shared_ptr<void>& context) {
   auto promise = static_pointer_cast<std::promise<shared_ptr<FileEngine>>>(context);
   promise->set_value(engine);
@@ -53,4 +75,9 @@ void ProfileObserver::OnAddEngineSuccess(const shared_ptr<FileEngine>& engine, c
 void ProfileObserver::OnAddEngineFailure(const std::exception_ptr& error, const shared_ptr<void>& context) {
   auto promise = static_pointer_cast<std::promise<shared_ptr<FileEngine>>>(context);
   promise->set_exception(error);
-}
\ No newline at end of file
+}
+
+void ProfileObserver::OnPolicyChanged(const string& engineId) {
+  if (mOnPolicyChanged)
+    mOnPolicyChanged(engineId);
+}
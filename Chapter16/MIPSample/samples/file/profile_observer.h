@@ -28,18 +28,32 @@
 #ifndef SAMPLE_PROFILE_OBSERVER_H_
 #define SAMPLE_PROFILE_OBSERVER_H_
 
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "mip/file/file_profile.h"
 
 class ProfileObserver final : public mip::FileProfile::Observer {
 public:
   ProfileObserver() { }
+  // onPolicyChanged is called with the engine ID whenever the SDK refreshes that engine's policy
+  explicit ProfileObserver(const std::function<void(const std::string&)>& onPolicyChanged)
+    : mOnPolicyChanged(onPolicyChanged) { }
   // Observer implementation
   void OnLoadSuccess(const std::shared_ptr<mip::FileProfile>& profile, const std::shared_ptr<void>& context) override;
   void OnLoadFailure(const std::exception_ptr& error, const std::shared_ptr<void>& context) override;
+  void OnListEnginesSuccess(const std::vector<std::string>& engineIds, const std::shared_ptr<void>& context) override;
+  void OnListEnginesFailure(const std::exception_ptr& error, const std::shared_ptr<void>& context) override;
+  void OnUnloadEngineSuccess(const std::shared_ptr<void>& context) override;
+  void OnUnloadEngineFailure(const std::exception_ptr& error, const std::shared_ptr<void>& context) override;
   void OnAddEngineSuccess(const std::shared_ptr<mip::FileEngine>& engine, const std::shared_ptr<void>& context) override;
   void OnAddEngineFailure(const std::exception_ptr& error, const std::shared_ptr<void>& context) override;
+  void OnPolicyChanged(const std::string& engineId) override;
+
+private:
+  std::function<void(const std::string&)> mOnPolicyChanged;
 };
 
 #endif // SAMPLE_PROFILE_OBSERVER_H_
\ No newline at end of file
@@ -0,0 +1,185 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "http_stub_server.h"
+
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using std::lock_guard;
+using std::mutex;
+using std::runtime_error;
+using std::string;
+using std::to_string;
+
+namespace {
+
+static const char kHeaderTerminator[] = "\r\n\r\n";
+
+// Content-Length of the request whose headers are headers, 0 if absent
+size_t GetContentLength(const string& headers) {
+  static const string kContentLength = "content-length:";
+  string lowered(headers);
+  for (auto& c : lowered)
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+
+  auto position = lowered.find(kContentLength);
+  if (position == string::npos)
+    return 0;
+  return static_cast<size_t>(strtoul(headers.c_str() + position + kContentLength.size(), nullptr, 10));
+}
+
+bool SendAll(int connection, const string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    auto count = send(connection, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (count <= 0)
+      return false;
+    sent += static_cast<size_t>(count);
+  }
+  return true;
+}
+
+} // namespace
+
+namespace sample {
+namespace http {
+
+HttpStubServer::HttpStubServer(const string& responseBody, std::chrono::milliseconds responseDelay)
+    : mResponse("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: keep-alive\r\nContent-Length: " +
+          to_string(responseBody.size()) + kHeaderTerminator + responseBody),
+      mResponseDelay(responseDelay),
+      mListenSocket(-1),
+      mPort(0),
+      mStopping(false),
+      mConnectionCount(0),
+      mRequestCount(0) {
+  mListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+  if (mListenSocket < 0)
+    throw runtime_error("Failed to create stub server socket");
+
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0; // Any free port
+  socklen_t addressLength = sizeof(address);
+  if (bind(mListenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(mListenSocket, SOMAXCONN) != 0 ||
+      getsockname(mListenSocket, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0) {
+    close(mListenSocket);
+    throw runtime_error("Failed to start stub server");
+  }
+  mPort = ntohs(address.sin_port);
+
+  mAcceptThread = std::thread(&HttpStubServer::AcceptLoop, this);
+}
+
+HttpStubServer::~HttpStubServer() {
+  mStopping = true;
+  // Shutting the sockets down unblocks accept() and recv() in the server threads
+  shutdown(mListenSocket, SHUT_RDWR);
+  mAcceptThread.join();
+  {
+    lock_guard<mutex> lock(mMutex);
+    for (int connection : mConnections)
+      shutdown(connection, SHUT_RDWR);
+  }
+  for (auto& thread : mConnectionThreads)
+    thread.join();
+  for (int connection : mConnections)
+    close(connection);
+  close(mListenSocket);
+}
+
+void HttpStubServer::AcceptLoop() {
+  while (!mStopping) {
+    int connection = accept(mListenSocket, nullptr, nullptr);
+    if (connection < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      // Out of descriptors or memory: give connections a moment to close instead of spinning on accept()
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        continue;
+      }
+      // The listening socket is unusable, e.g. shut down by the destructor
+      break;
+    }
+
+    int noDelay = 1;
+    setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    lock_guard<mutex> lock(mMutex);
+    if (mStopping) {
+      close(connection);
+      break;
+    }
+    mConnectionCount++;
+    mConnections.push_back(connection);
+    mConnectionThreads.emplace_back(&HttpStubServer::ServeConnection, this, connection);
+  }
+}
+
+void HttpStubServer::ServeConnection(int connection) {
+  string pending;
+  char buffer[16 * 1024];
+
+  while (!mStopping) {
+    // Wait for a complete request: headers plus Content-Length bytes of body
+    auto headersEnd = pending.find(kHeaderTerminator);
+    if (headersEnd != string::npos) {
+      size_t requestLength = headersEnd + strlen(kHeaderTerminator) + GetContentLength(pending.substr(0, headersEnd));
+      if (pending.size() >= requestLength) {
+        pending.erase(0, requestLength);
+        mRequestCount++;
+        if (mResponseDelay.count() > 0)
+          std::this_thread::sleep_for(mResponseDelay);
+        if (!SendAll(connection, mResponse))
+          return;
+        continue;
+      }
+    }
+
+    auto received = recv(connection, buffer, sizeof(buffer), 0);
+    if (received <= 0)
+      return; // Client closed the connection or the server is stopping
+    pending.append(buffer, static_cast<size_t>(received));
+  }
+}
+
+} // namespace http
+} // namespace sample
@@ -0,0 +1,77 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SAMPLE_HTTP_STUB_SERVER_H_
+#define SAMPLE_HTTP_STUB_SERVER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sample {
+namespace http {
+
+// Minimal HTTP/1.1 server on the loopback interface that answers every request with the same canned response after
+// an optional delay. Connections are kept alive, so a client that reuses connections is visible in the connection
+// count. Only meant for benchmarking HTTP delegates without network access.
+class HttpStubServer final {
+public:
+  HttpStubServer(const std::string& responseBody, std::chrono::milliseconds responseDelay);
+  ~HttpStubServer();
+
+  HttpStubServer(const HttpStubServer&) = delete;
+  HttpStubServer& operator=(const HttpStubServer&) = delete;
+
+  uint16_t GetPort() const { return mPort; }
+  size_t GetConnectionCount() const { return mConnectionCount; }
+  size_t GetRequestCount() const { return mRequestCount; }
+
+private:
+  void AcceptLoop();
+  void ServeConnection(int connection);
+
+  std::string mResponse;
+  std::chrono::milliseconds mResponseDelay;
+  int mListenSocket;
+  uint16_t mPort;
+  std::atomic<bool> mStopping;
+  std::atomic<size_t> mConnectionCount;
+  std::atomic<size_t> mRequestCount;
+  std::mutex mMutex;
+  std::vector<int> mConnections;
+  std::vector<std::thread> mConnectionThreads;
+  std::thread mAcceptThread;
+};
+
+} // namespace http
+} // namespace sample
+
+#endif // SAMPLE_HTTP_STUB_SERVER_H_
@@ -0,0 +1,136 @@
+/**
+ *
+ * Copyright (c) Microsoft Corporation.
+ * All rights reserved.
+ *
+ * This code is licensed under the MIT License.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cxxopts.hpp"
+
+#include "http_message_impl.h"
+#include "http_stub_server.h"
+#include "latency_recorder.h"
+#include "pooled_http_delegate.h"
+
+using mip::HttpRequestType;
+using sample::http::HttpHeaders;
+using sample::http::HttpRequestImpl;
+using sample::http::HttpStubServer;
+using sample::http::PooledHttpDelegate;
+using std::atomic;
+using std::cout;
+using std::endl;
+using std::make_shared;
+using std::string;
+using std::vector;
+
+namespace {
+
+int GetIntOption(cxxopts::Options& options, const string& name, int defaultValue) {
+  if (!options.count(name))
+    return defaultValue;
+  int value = options[name].as<int>();
+  return value > 0 ? value : defaultValue;
+}
+
+} // namespace
+
+// Benchmarks PooledHttpDelegate against a loopback stub server, so the effect of connection reuse and of the
+// per-host connection limit can be measured without network access.
+int main(int argc, char** argv) {
+  try {
+    cxxopts::Options options("http_bench", "Benchmark for the pooled HttpDelegate against a loopback stub server");
+    options.add_options()
+      ("requests", "Total number of requests to send (Default=10000)", cxxopts::value<int>())
+      ("threads", "Number of threads sending requests (Default=16)", cxxopts::value<int>())
+      ("connections", "Maximum connections per host (Default=8)", cxxopts::value<int>())
+      ("delay", "Stub server response delay in milliseconds (Default=0)", cxxopts::value<int>())
+      ("bodysize", "Size of request and response bodies in bytes (Default=1024)", cxxopts::value<int>())
+      ("h,help", "Print help and exit.");
+    options.parse(argc, argv);
+
+    if (options.count("help")) {
+      cout << options.help({ "" }) << endl;
+      return 0;
+    }
+
+    const int requestCount = GetIntOption(options, "requests", 10000);
+    const int threadCount = GetIntOption(options, "threads", 16);
+    const int connections = GetIntOption(options, "connections", 8);
+    const int delay = options.count("delay") ? options["delay"].as<int>() : 0;
+    const int bodySize = GetIntOption(options, "bodysize", 1024);
+
+    const string body(static_cast<size_t>(bodySize), 'x');
+    HttpStubServer server(body, std::chrono::milliseconds(delay));
+    PooledHttpDelegate httpDelegate(static_cast<size_t>(connections));
+
+    const string url = "http://127.0.0.1:" + std::to_string(server.GetPort()) + "/my/v1.0/me/protection";
+    HttpHeaders headers;
+    headers["Content-Type"] = "application/json";
+    auto request = make_shared<HttpRequestImpl>(HttpRequestType::Post, url, body, headers);
+
+    atomic<int> next(0);
+    atomic<int> failures(0);
+    const auto start = std::chrono::steady_clock::now();
+
+    vector<std::thread> threads;
+    for (int i = 0; i < threadCount; i++) {
+      threads.emplace_back([&]() {
+        while (next++ < requestCount) {
+          try {
+            auto response = httpDelegate.Send(request, nullptr);
+            if (response->GetStatusCode() != 200 || response->GetBody().size() != body.size())
+              failures++;
+          } catch (const std::exception&) {
+            failures++;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cout << "Requests: " << requestCount << " (" << failures << " failed) in " << seconds << "s, "
+        << requestCount / seconds << " requests/sec" << endl;
+    cout << "Latency: " << httpDelegate.GetLatencySummary() << endl;
+    cout << "Connections opened: " << httpDelegate.GetConnectionCount() << " (server accepted "
+        << server.GetConnectionCount() << ")" << endl;
+  } catch (const cxxopts::OptionException& ex) {
+    cout << "Error parsing options: " << ex.what() << endl;
+    return -1;
+  } catch (const std::exception& ex) {
+    cout << "Something bad happend: " << ex.what() << "\nExiting." << endl;
+    return -1;
+  }
+
+  return 0;
+}